@@ -0,0 +1,133 @@
+/* *******************************************************************
+ * Benchmark dos kernels espectrais: escalar vs SIMD
+ * Nao usa o SDL nem o dispositivo de audio (make bench)
+ *
+ * Para cada N e cada variante de kernels suportada pelo CPU mede:
+ *   - fftfRealExecute (FFT real float32)
+ *   - magnitude (fftfAmplitude) e procura de pico
+ * e compara com a FFT real double (fftRealExecute) e com a FFT
+ * recursiva de referencia (fftCompute) para o erro numerico.
+ * *******************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include <complex.h>
+#include "fft.h"
+#include "fftf.h"
+
+static double now_ns(void)
+{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+// n de repeticoes para ~50 ms por medicao
+static int reps_for(int N)
+{
+	int r = (int)(4000000 / N);
+	return r < 20 ? 20 : r;
+}
+
+int main(void)
+{
+	const int sizes[] = {1024, 4096, 16384, 65536};
+	const int nsizes = sizeof(sizes) / sizeof(sizes[0]);
+
+	printf("best kernels: %s\n\n", fftfBestKernels()->name);
+	printf("%-8s %-8s %12s %12s %12s %10s %10s\n",
+		   "N", "kernels", "fft ns", "mag ns", "peak ns", "speedup", "max err");
+
+	for (int s = 0; s < nsizes; s++)
+	{
+		const int N = sizes[s];
+		const int reps = reps_for(N);
+
+		float *x = aligned_alloc(32, sizeof(float) * N);
+		float *amp = aligned_alloc(32, sizeof(float) * (N / 2 + 1 + 8));
+		double *xd = malloc(sizeof(double) * N);
+		complex double *Y = malloc(sizeof(complex double) * (N / 2 + 1));
+		complex double *ref = malloc(sizeof(complex double) * N);
+		if (!x || !amp || !xd || !Y || !ref)
+		{
+			fprintf(stderr, "bench: out of memory\n");
+			return 1;
+		}
+
+		// Sinal de teste: tom de 3 kHz + harmonica + ruido, gama de 16 bits
+		srand(1);
+		for (int i = 0; i < N; i++)
+		{
+			double v = 8000.0 * sin(2.0 * M_PI * 3000.0 * i / 44100.0) +
+					   2000.0 * sin(2.0 * M_PI * 6000.0 * i / 44100.0) +
+					   500.0 * (rand() / (double)RAND_MAX - 0.5);
+			x[i] = (float)v;
+			xd[i] = v;
+			ref[i] = v;
+		}
+		fftCompute(ref, N);
+		double ref_max = 0.0;
+		for (int k = 0; k <= N / 2; k++)
+			if (cabs(ref[k]) > ref_max)
+				ref_max = cabs(ref[k]);
+
+		// Referencia double (FFT real, escalar)
+		FFTRealPlan *dp = fftRealPlanCreate(N);
+		double t0 = now_ns();
+		for (int r = 0; r < reps; r++)
+			fftRealExecute(dp, xd, Y);
+		double t_double = (now_ns() - t0) / reps;
+		fftRealPlanDestroy(dp);
+		printf("%-8d %-8s %12.0f %12s %12s %10s %10s\n", N, "double", t_double, "-", "-", "-", "-");
+
+		double t_scalar = 0.0;
+		for (int isa = 0; isa < FFTF_ISA_COUNT; isa++)
+		{
+			const FFTFKernels *k = fftfKernels((FFTFIsa)isa);
+			if (!k)
+				continue;
+			FFTFPlan *p = fftfPlanCreate(N, k);
+
+			t0 = now_ns();
+			for (int r = 0; r < reps; r++)
+				fftfRealExecute(p, x);
+			double t_fft = (now_ns() - t0) / reps;
+
+			t0 = now_ns();
+			for (int r = 0; r < reps; r++)
+				fftfAmplitude(p, amp, 1.0f / N);
+			double t_mag = (now_ns() - t0) / reps;
+
+			volatile int pk = 0;
+			t0 = now_ns();
+			for (int r = 0; r < reps; r++)
+				pk += k->peak(amp, 0, N / 2);
+			double t_peak = (now_ns() - t0) / reps;
+
+			// Erro maximo relativo ao maior bin da referencia
+			double err = 0.0;
+			for (int b = 0; b <= N / 2; b++)
+			{
+				double e = cabs(CMPLX(p->re[b], p->im[b]) - ref[b]);
+				if (e > err)
+					err = e;
+			}
+
+			if (isa == FFTF_ISA_SCALAR)
+				t_scalar = t_fft + t_mag + t_peak;
+			printf("%-8d %-8s %12.0f %12.0f %12.0f %9.2fx %10.2e\n", N, k->name,
+				   t_fft, t_mag, t_peak, t_scalar / (t_fft + t_mag + t_peak), err / ref_max);
+
+			fftfPlanDestroy(p);
+		}
+		printf("\n");
+
+		free(x);
+		free(amp);
+		free(xd);
+		free(Y);
+		free(ref);
+	}
+	return 0;
+}
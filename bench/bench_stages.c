@@ -0,0 +1,586 @@
+/* *******************************************************************
+ * Benchmark por estagio do pipeline (make bench)
+ * Nao usa o SDL nem o dispositivo de audio
+ *
+ * Para cada tamanho de bloco N (256 .. 65536) mede cada kernel que
+ * corre por bloco:
+ *   - filterLP                  (filtro passa-baixo original, in place)
+ *   - iir                       (Butterworth de ordem LPF_ORDER com estado,
+ *                                o filtro usado pelo dispatcher)
+ *   - decim                     (FIR polifasico, fator DECIM_FACTOR)
+ *   - fftCompute                (FFT recursiva de referencia)
+ *   - fftGetAmplitude           (amplitudes a partir da FFT complexa)
+ *   - spectrum                  (janela Hann + FFT real float32 + amplitudes,
+ *                                o caminho usado pelo dispatcher)
+ *   - compute_dominant_freq     (speed)
+ *   - speed_track               (speed com lock a volta da ultima estimativa,
+ *                                procura completa a cada SPEED_TRACK_REACQUIRE)
+ *   - compute_bearing_issue_freq (bearing, a partir do espectro)
+ *   - bearing_bank              (bearing com o banco de Goertzel do dispatcher,
+ *                                os bins LF a cada bloco e a FFT do motor a
+ *                                cada BEARING_MOTOR_PERIOD_MS, sobre as
+ *                                amostras decimadas do bloco; o p99 inclui
+ *                                os blocos com a FFT)
+ * e reporta percentis de ns/bloco, amostras/s e ciclos/amostra.
+ *
+ * No fim de cada N compara o custo por bloco com os periodos das tarefas
+ * (speed 200 ms, bearing 1 s) para saber quanta folga ha.
+ *
+ * Antes das medicoes verifica que o bearing_bank toma a mesma decisao que
+ * compute_bearing_issue_freq (espectro de BEARING_N pontos da mesma janela)
+ * com motores perto do limite da banda (BEARING_MOTOR_MIN) e tons LF a volta
+ * do limiar relativo.
+ *
+ * Uso: bench_stages [-j] [-n N] [-s amostras]
+ *   -j  saida em JSON (para guardar e comparar ao longo do tempo)
+ *   -n  so o tamanho N
+ *   -s  n de medicoes por kernel (omissao 200)
+ * *******************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <complex.h>
+#include "config.h"
+#include "fft.h"
+#include "fftf.h"
+#include "lpf.h"
+#include "iir.h"
+#include "decim.h"
+#include "goertzel.h"
+#include "spectrum.h"
+#include "speed_track.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC 1
+static inline uint64_t cycles_now(void) { return __rdtsc(); }
+#else
+#define HAVE_TSC 0
+static inline uint64_t cycles_now(void) { return 0; }
+#endif
+
+// Periodos das tarefas consumidoras (ms)
+#define SPEED_PERIOD_MS 200.0
+#define BEARING_PERIOD_MS 1000.0
+
+// Cada medicao dura pelo menos isto (agrupa repeticoes dos kernels rapidos)
+#define MIN_SAMPLE_NS 2000.0
+
+static double now_ns(void)
+{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+// NOTE - Estado partilhado pelos kernels de um tamanho N
+typedef struct
+{
+	int N;
+	int16_t *pcm;			// bloco de entrada S16
+	int16_t *pcm_work;		// copia filtrada in place
+	IIRFilter iir;			// passa-baixo do dispatcher
+	float *filtered;		// saida do iir
+	Decimator decim;		// decimador do dispatcher
+	float *lowrate;			// saida do decim (N/DECIM_FACTOR + 1)
+	BearingBank bbank;		// detetor do bearing por Goertzel
+	complex double *X;		// entrada/saida da fftCompute
+	float *fk, *Ak;			// saida da fftGetAmplitude (N/2+1)
+	float *window, *xw;		// janela Hann e bloco com janela (tambem spec.xw)
+	float window_gain;
+	FFTFPlan *plan;
+	Spectrum spec;			// espectro lido pelos kernels de analise
+	SpeedTracker trk;		// seguidor do speed sobre spec
+	float last_hz;			// ultima estimativa do speed_track
+	volatile float sink;	// impede o compilador de eliminar resultados
+} Ctx;
+
+// NOTE - Kernels: prepare (fora da medicao, pode ser NULL) e run
+typedef struct
+{
+	const char *name;
+	void (*prepare)(Ctx *c);
+	void (*run)(Ctx *c);
+} Stage;
+
+static void prep_filter(Ctx *c)
+{
+	memcpy(c->pcm_work, c->pcm, sizeof(int16_t) * c->N);
+}
+
+static void run_filter(Ctx *c)
+{
+	filterLP(CUTOFF_HZ, SAMP_FREQ, (uint8_t *)c->pcm_work, c->N);
+}
+
+static void run_iir(Ctx *c)
+{
+	iir_process_s16(&c->iir, c->pcm, c->filtered, c->N);
+}
+
+static void run_decim(Ctx *c)
+{
+	c->sink = (float)decim_process(&c->decim, c->filtered, c->N, c->lowrate);
+}
+
+static void prep_fft(Ctx *c)
+{
+	for (int i = 0; i < c->N; i++)
+		c->X[i] = c->pcm[i];
+}
+
+static void run_fft(Ctx *c)
+{
+	fftCompute(c->X, c->N);
+}
+
+static void run_amplitude(Ctx *c)
+{
+	fftGetAmplitude(c->X, c->N, SAMP_FREQ, c->fk, c->Ak);
+}
+
+static void run_spectrum(Ctx *c)
+{
+	for (int i = 0; i < c->N; i++)
+		c->xw[i] = (float)c->pcm[i] * c->window[i];
+	fftfRealExecute(c->plan, c->xw);
+	fftfAmplitude(c->plan, c->spec.amp, c->window_gain);
+}
+
+static void run_dominant(Ctx *c)
+{
+	c->sink = compute_dominant_freq(&c->spec);
+}
+
+// Realimentado com a propria estimativa, como a RTDB no speed
+static void run_speed_track(Ctx *c)
+{
+	c->last_hz = speed_track_update(&c->trk, &c->spec, c->last_hz);
+	c->sink = c->last_hz;
+}
+
+static void run_bearing(Ctx *c)
+{
+	c->sink = compute_bearing_issue_freq(&c->spec, BEARING_MOTOR_MIN, BEARING_MOTOR_MAX,
+										 BEARING_LOWF_TH, BEARING_REL_TH);
+}
+
+// Sobre as N/DECIM_FACTOR amostras da taxa baixa de um bloco, como no dispatcher
+static void run_bearing_bank(Ctx *c)
+{
+	c->sink = bearing_bank_update(&c->bbank, c->lowrate, c->N / DECIM_FACTOR);
+}
+
+// fftGetAmplitude le o resultado da fftCompute: a ordem dos estagios importa
+static const Stage stages[] = {
+	{"filterLP", prep_filter, run_filter},
+	{"iir", NULL, run_iir},
+	{"decim", NULL, run_decim},
+	{"fftCompute", prep_fft, run_fft},
+	{"fftGetAmplitude", NULL, run_amplitude},
+	{"spectrum", NULL, run_spectrum},
+	{"compute_dominant_freq", NULL, run_dominant},
+	{"speed_track", NULL, run_speed_track},
+	{"compute_bearing_issue_freq", NULL, run_bearing},
+	{"bearing_bank", NULL, run_bearing_bank},
+};
+#define NSTAGES (int)(sizeof(stages) / sizeof(stages[0]))
+enum
+{
+	ST_FILTER,
+	ST_IIR,
+	ST_DECIM,
+	ST_FFT,
+	ST_AMPLITUDE,
+	ST_SPECTRUM,
+	ST_DOMINANT,
+	ST_SPEED_TRACK,
+	ST_BEARING,
+	ST_BEARING_BANK
+};
+
+// NOTE - Resultado de um kernel (por bloco)
+typedef struct
+{
+	double min, p50, p90, p99, max; // ns/bloco
+	double cycles_p50;				// ciclos TSC/bloco na mediana
+	int batch;						// repeticoes por medicao
+} Result;
+
+static int cmp_double(const void *a, const void *b)
+{
+	double x = *(const double *)a, y = *(const double *)b;
+	return (x > y) - (x < y);
+}
+
+static double percentile(const double *sorted, int n, double p)
+{
+	int i = (int)ceil(p / 100.0 * n) - 1;
+	if (i < 0)
+		i = 0;
+	if (i >= n)
+		i = n - 1;
+	return sorted[i];
+}
+
+static Result measure(const Stage *st, Ctx *c, int nsamples)
+{
+	Result r;
+	double *ns = malloc(sizeof(double) * nsamples);
+	double *cyc = malloc(sizeof(double) * nsamples);
+
+	// Aquecimento e escolha do tamanho do lote
+	// (kernels com prepare correm um de cada vez)
+	if (st->prepare)
+		st->prepare(c);
+	double t0 = now_ns();
+	st->run(c);
+	double once = now_ns() - t0;
+	r.batch = 1;
+	if (!st->prepare && once < MIN_SAMPLE_NS)
+		r.batch = (int)(MIN_SAMPLE_NS / (once > 1.0 ? once : 1.0)) + 1;
+
+	for (int s = 0; s < nsamples; s++)
+	{
+		if (st->prepare)
+			st->prepare(c);
+		uint64_t c0 = cycles_now();
+		t0 = now_ns();
+		for (int b = 0; b < r.batch; b++)
+			st->run(c);
+		ns[s] = (now_ns() - t0) / r.batch;
+		cyc[s] = (double)(cycles_now() - c0) / r.batch;
+	}
+
+	qsort(ns, nsamples, sizeof(double), cmp_double);
+	qsort(cyc, nsamples, sizeof(double), cmp_double);
+	r.min = ns[0];
+	r.p50 = percentile(ns, nsamples, 50);
+	r.p90 = percentile(ns, nsamples, 90);
+	r.p99 = percentile(ns, nsamples, 99);
+	r.max = ns[nsamples - 1];
+	r.cycles_p50 = percentile(cyc, nsamples, 50);
+
+	free(ns);
+	free(cyc);
+	return r;
+}
+
+static int ctx_init(Ctx *c, int N)
+{
+	memset(c, 0, sizeof(*c));
+	c->N = N;
+	c->pcm = malloc(sizeof(int16_t) * N);
+	c->pcm_work = malloc(sizeof(int16_t) * N);
+	c->X = malloc(sizeof(complex double) * N);
+	c->fk = malloc(sizeof(float) * (N / 2 + 1));
+	c->Ak = malloc(sizeof(float) * (N / 2 + 1));
+	c->window = aligned_alloc(32, sizeof(float) * N);
+	c->xw = aligned_alloc(32, sizeof(float) * N);
+	c->spec.amp = aligned_alloc(32, sizeof(float) * (N / 2 + 1 + 8));
+	c->filtered = aligned_alloc(32, sizeof(float) * N);
+	c->lowrate = malloc(sizeof(float) * (N / DECIM_FACTOR + 1));
+	c->plan = fftfPlanCreate(N, NULL);
+	if (iir_design_butter_lp(&c->iir, LPF_ORDER, CUTOFF_HZ, SAMP_FREQ) != 0 ||
+		iir_set_block(&c->iir, N) != 0 ||
+		decim_init(&c->decim, DECIM_FACTOR, DECIM_TAPS_PER_PHASE, DECIM_CUTOFF, N) != 0 ||
+		bearing_bank_init(&c->bbank, BEARING_N, ANALYSIS_FS, N / DECIM_FACTOR,
+						  BEARING_MOTOR_MIN, BEARING_MOTOR_MAX,
+						  BEARING_LOWF_TH, BEARING_REL_TH) != 0 ||
+		speed_track_init(&c->trk, N, SAMP_FREQ, SPEED_TRACK_SPAN_HZ) != 0)
+		return -1;
+	if (!c->pcm || !c->pcm_work || !c->filtered || !c->lowrate || !c->X || !c->fk || !c->Ak ||
+		!c->window || !c->xw || !c->spec.amp || !c->plan)
+		return -1;
+
+	// Sinal de motor: fundamental 300 Hz + harmonicas + tom LF + ruido
+	srand(1);
+	for (int i = 0; i < N; i++)
+	{
+		double t = (double)i / SAMP_FREQ;
+		double v = 6000.0 * sin(2.0 * M_PI * 300.0 * t) +
+				   3000.0 * sin(2.0 * M_PI * 600.0 * t) +
+				   1500.0 * sin(2.0 * M_PI * 900.0 * t) +
+				   1000.0 * sin(2.0 * M_PI * 40.0 * t) +
+				   200.0 * (rand() / (double)RAND_MAX - 0.5);
+		c->pcm[i] = (int16_t)v;
+	}
+
+	double window_sum = 0.0;
+	for (int i = 0; i < N; i++)
+	{
+		c->window[i] = (float)(0.5 * (1.0 - cos(2.0 * M_PI * i / (N - 1))));
+		window_sum += c->window[i];
+	}
+	c->window_gain = (float)(1.0 / window_sum);
+
+	c->spec.xw = c->xw;
+	c->spec.re = c->plan->re;
+	c->spec.im = c->plan->im;
+	c->spec.N = N;
+	c->spec.nbins = N / 2 + 1;
+	c->spec.fs = SAMP_FREQ;
+	return 0;
+}
+
+static void ctx_destroy(Ctx *c)
+{
+	free(c->pcm);
+	free(c->pcm_work);
+	free(c->X);
+	free(c->fk);
+	free(c->Ak);
+	free(c->window);
+	free(c->xw);
+	free(c->spec.amp);
+	free(c->filtered);
+	iir_destroy(&c->iir);
+	decim_destroy(&c->decim);
+	bearing_bank_destroy(&c->bbank);
+	free(c->lowrate);
+	fftfPlanDestroy(c->plan);
+}
+
+// NOTE - Verificacao do banco contra o detetor de referencia
+// Motor de f0 Hz (com 2a harmonica) e tom LF de amplitude rel * motor, pelo
+// caminho do dispatcher (iir + decim); retorna o n de casos com decisoes
+// diferentes e a maior diferenca relativa entre os picos do motor
+static int check_bearing_bank(int *ncases, double *max_motor_err)
+{
+	const int n = ABUFSIZE_SAMPLES, nlow = n / DECIM_FACTOR, N = BEARING_N;
+	int16_t *pcm = malloc(sizeof(int16_t) * n);
+	float *filt = aligned_alloc(32, sizeof(float) * n);
+	float *low = malloc(sizeof(float) * (nlow + 1));
+	float *win = calloc(N, sizeof(float));
+	float *w = malloc(sizeof(float) * N);
+	float *xw = aligned_alloc(32, sizeof(float) * N);
+	float *amp = aligned_alloc(32, sizeof(float) * (N / 2 + 8));
+	FFTFPlan *plan = fftfPlanCreate(N, NULL);
+	double wsum = 0.0;
+	for (int i = 0; i < N; i++)
+	{
+		w[i] = (float)(0.5 * (1.0 - cos(2.0 * M_PI * i / (N - 1))));
+		wsum += w[i];
+	}
+
+	const double f0s[] = {190.0, 198.0, 203.0, 207.0, 212.0, 218.0, 240.0, 300.0};
+	const double lfs[] = {40.0, 95.0, 140.0};
+	const double rels[] = {0.15, 0.22, 0.28, 0.4};
+	int bad = 0;
+	*ncases = 0;
+	*max_motor_err = 0.0;
+	for (size_t a = 0; a < sizeof(f0s) / sizeof(f0s[0]); a++)
+		for (size_t l = 0; l < sizeof(lfs) / sizeof(lfs[0]); l++)
+			for (size_t r = 0; r < sizeof(rels) / sizeof(rels[0]); r++)
+			{
+				IIRFilter iir;
+				Decimator decim;
+				BearingBank bank;
+				if (iir_design_butter_lp(&iir, LPF_ORDER, CUTOFF_HZ, SAMP_FREQ) != 0 ||
+					iir_set_block(&iir, n) != 0 ||
+					decim_init(&decim, DECIM_FACTOR, DECIM_TAPS_PER_PHASE, DECIM_CUTOFF, n) != 0 ||
+					bearing_bank_init(&bank, N, ANALYSIS_FS, nlow + 1, BEARING_MOTOR_MIN,
+									  BEARING_MOTOR_MAX, BEARING_LOWF_TH, BEARING_REL_TH) != 0)
+					return -1;
+				int fault = 0;
+				// Blocos suficientes para encher a janela de N amostras da taxa baixa
+				for (int blk = 0; blk * nlow < 2 * N; blk++)
+				{
+					for (int i = 0; i < n; i++)
+					{
+						double t = (double)(blk * n + i) / SAMP_FREQ;
+						double v = 6000.0 * sin(2.0 * M_PI * f0s[a] * t) +
+								   2000.0 * sin(4.0 * M_PI * f0s[a] * t) +
+								   6000.0 * rels[r] * sin(2.0 * M_PI * lfs[l] * t);
+						pcm[i] = (int16_t)v;
+					}
+					iir_process_s16(&iir, pcm, filt, n);
+					int m = decim_process(&decim, filt, n, low);
+					memmove(win, win + m, sizeof(float) * (N - m));
+					memcpy(win + N - m, low, sizeof(float) * m);
+					fault = bearing_bank_update(&bank, low, m);
+				}
+
+				for (int i = 0; i < N; i++)
+					xw[i] = win[i] * w[i];
+				fftfRealExecute(plan, xw);
+				fftfAmplitude(plan, amp, (float)(1.0 / wsum));
+				Spectrum s = {.amp = amp, .re = plan->re, .im = plan->im, .xw = xw,
+							  .N = N, .nbins = N / 2 + 1, .fs = ANALYSIS_FS};
+				int ref = compute_bearing_issue_freq(&s, BEARING_MOTOR_MIN, BEARING_MOTOR_MAX,
+													 BEARING_LOWF_TH, BEARING_REL_TH);
+
+				// Pico da banda do motor da referencia (mesmos limites)
+				const float bph = N / ANALYSIS_FS;
+				int kmin = (int)ceilf(BEARING_MOTOR_MIN * bph), kmax = (int)floorf(BEARING_MOTOR_MAX * bph);
+				if (kmax > N / 2 - 1)
+					kmax = N / 2 - 1;
+				float ref_motor = 0.0f;
+				for (int k = kmin; k <= kmax; k++)
+					if (amp[k] > ref_motor)
+						ref_motor = amp[k];
+				double err = fabs(bank.motor_peak - ref_motor) / ref_motor;
+				if (err > *max_motor_err)
+					*max_motor_err = err;
+				if (fault != ref)
+				{
+					bad++;
+					fprintf(stderr, "bearing_bank: f0=%.0f lf=%.0f rel=%.2f bank=%d ref=%d\n",
+							f0s[a], lfs[l], rels[r], fault, ref);
+				}
+				(*ncases)++;
+				iir_destroy(&iir);
+				decim_destroy(&decim);
+				bearing_bank_destroy(&bank);
+			}
+
+	fftfPlanDestroy(plan);
+	free(pcm);
+	free(filt);
+	free(low);
+	free(win);
+	free(w);
+	free(xw);
+	free(amp);
+	return bad;
+}
+
+static void usage(const char *prog)
+{
+	fprintf(stderr, "Usage: %s [-j] [-n N] [-s samples]\n"
+					"  -j  JSON output\n"
+					"  -n  only block size N (power of 2, 256..65536)\n"
+					"  -s  measurements per kernel (default 200)\n",
+			prog);
+}
+
+int main(int argc, char **argv)
+{
+	int json = 0, only_n = 0, nsamples = 200;
+	int opt;
+	while ((opt = getopt(argc, argv, "jn:s:")) != -1)
+	{
+		switch (opt)
+		{
+		case 'j':
+			json = 1;
+			break;
+		case 'n':
+			only_n = atoi(optarg);
+			break;
+		case 's':
+			nsamples = atoi(optarg);
+			break;
+		default:
+			usage(argv[0]);
+			return 1;
+		}
+	}
+	if (nsamples < 1)
+		nsamples = 1;
+
+	const int sizes[] = {256, 512, 1024, 2048, 4096, 8192, 16384, 32768, 65536};
+	const int nsizes = sizeof(sizes) / sizeof(sizes[0]);
+
+	// Frequencia do TSC (para ciclos/amostra com clock fixo)
+	double tsc_ghz = 0.0;
+	if (HAVE_TSC)
+	{
+		uint64_t c0 = cycles_now();
+		double t0 = now_ns();
+		while (now_ns() - t0 < 50e6)
+			;
+		tsc_ghz = (double)(cycles_now() - c0) / (now_ns() - t0);
+	}
+
+	int ncases;
+	double motor_err;
+	int mismatches = check_bearing_bank(&ncases, &motor_err);
+	if (mismatches < 0)
+	{
+		fprintf(stderr, "bench_stages: out of memory (bearing check)\n");
+		return 1;
+	}
+
+	if (json)
+		printf("{\n  \"kernels\": \"%s\",\n  \"tsc_ghz\": %.3f,\n  \"samples\": %d,\n"
+			   "  \"fs\": %d,\n  \"bearing_check\": {\"cases\": %d, \"mismatches\": %d, "
+			   "\"motor_peak_rel_err\": %.2e},\n  \"results\": [",
+			   fftfBestKernels()->name, tsc_ghz, nsamples, SAMP_FREQ, ncases, mismatches, motor_err);
+	else
+		printf("kernels: %s, TSC %.3f GHz, %d measurements per kernel\n"
+			   "bearing_bank vs compute_bearing_issue_freq: %d/%d decisions differ, "
+			   "motor peak rel. error %.2e\n",
+			   fftfBestKernels()->name, tsc_ghz, nsamples, mismatches, ncases, motor_err);
+
+	int first = 1;
+	for (int s = 0; s < nsizes; s++)
+	{
+		const int N = sizes[s];
+		if (only_n && N != only_n)
+			continue;
+
+		Ctx c;
+		if (ctx_init(&c, N) != 0)
+		{
+			fprintf(stderr, "bench_stages: out of memory (N=%d)\n", N);
+			return 1;
+		}
+
+		if (!json)
+			printf("\nN=%d (%.1f ms of audio)\n%-28s %10s %10s %10s %10s %10s %12s %10s\n",
+				   N, 1000.0 * N / SAMP_FREQ, "kernel", "min ns", "p50 ns", "p90 ns",
+				   "p99 ns", "max ns", "Msamples/s", "cyc/samp");
+
+		Result res[NSTAGES];
+		for (int i = 0; i < NSTAGES; i++)
+		{
+			Result r = measure(&stages[i], &c, nsamples);
+			res[i] = r;
+			double msps = N / r.p50 * 1e3;
+			double cps = HAVE_TSC ? r.cycles_p50 / N : -1.0;
+
+			if (json)
+			{
+				printf("%s\n    {\"N\": %d, \"kernel\": \"%s\", \"batch\": %d, "
+					   "\"ns_min\": %.1f, \"ns_p50\": %.1f, \"ns_p90\": %.1f, "
+					   "\"ns_p99\": %.1f, \"ns_max\": %.1f, \"samples_per_s\": %.0f, ",
+					   first ? "" : ",", N, stages[i].name, r.batch,
+					   r.min, r.p50, r.p90, r.p99, r.max, msps * 1e6);
+				if (HAVE_TSC)
+					printf("\"cycles_per_sample\": %.3f}", cps);
+				else
+					printf("\"cycles_per_sample\": null}");
+				first = 0;
+			}
+			else
+				printf("%-28s %10.0f %10.0f %10.0f %10.0f %10.0f %12.1f %10.2f\n",
+					   stages[i].name, r.min, r.p50, r.p90, r.p99, r.max, msps, cps);
+		}
+
+		// NOTE - Orcamento: um bloco por ativacao de cada tarefa
+		// speed = iir + decim + spectrum + dominante, bearing = iir + decim + banco
+		// (filtro e espectro correm uma vez no dispatcher; contam nas duas por seguranca)
+		// O espectro e as analises sao medidos em N; no dispatcher correm em
+		// ANALYSIS_N amostras da taxa baixa, por isso isto e um limite superior
+		double speed_ns = res[ST_IIR].p99 + res[ST_DECIM].p99 + res[ST_SPECTRUM].p99 + res[ST_DOMINANT].p99;
+		double bearing_ns = res[ST_IIR].p99 + res[ST_DECIM].p99 + res[ST_BEARING_BANK].p99;
+		double speed_use = speed_ns / (SPEED_PERIOD_MS * 1e6);
+		double bearing_use = bearing_ns / (BEARING_PERIOD_MS * 1e6);
+		if (!json)
+			printf("budget (p99): speed %.3f%% of %.0f ms, bearing %.4f%% of %.0f ms "
+				   "-> fits on a CPU up to %.0fx slower\n",
+				   100.0 * speed_use, SPEED_PERIOD_MS, 100.0 * bearing_use, BEARING_PERIOD_MS,
+				   1.0 / (speed_use > bearing_use ? speed_use : bearing_use));
+
+		ctx_destroy(&c);
+	}
+
+	if (json)
+		printf("\n  ]\n}\n");
+	return 0;
+}
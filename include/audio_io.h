@@ -3,15 +3,36 @@
 #include <SDL.h>
 #include <stdint.h>
 #include "buffer.h"
+#include "channel.h"
 
-extern SDL_AudioDeviceID gRecDev;
-
-extern AudioBuf bufA, bufB;
-extern AudioBuf *curBuf;
+// Dispositivo SDL que alimenta cada canal (0 = outra fonte)
+extern SDL_AudioDeviceID gRecDev[MAX_CHANNELS];
 
+// userdata: a AudioSource do dispositivo (canais first_channel..)
 void audio_recording_callback(void *userdata, Uint8 *stream, int len);
 
-// NOTE - wrapper que faz o lock/unlock e liberta o buffer
-void audio_release_buffer(int16_t *ptr);
+// NOTE - Entrada comum de todas as fontes de audio
+// Os blocos vao para a pool do canal (gChannels) e acordam o worker
+// do dispatcher que o trata
+// So atomicos (buffer.h): nenhum consumidor precisa do lock do dispositivo
+// As amostras passam pelo estagio de ingestao (ingest.h): o formato e o da
+// fonte e os blocos da pool ficam em float32, ja sem DC
+// Junta len amostras de um canal (fmt mono) aos blocos da pool (len pode ser
+// menor ou maior do que um bloco: o resto fica para a chamada seguinte)
+// Retorna o n de blocos completos entregues ao dispatcher
+int audio_capture_push(int ch, const IngestFormat *fmt, const void *samples, int len);
+// Separa nframes tramas intercaladas de fmt->channels canais pelas pools dos
+// canais first_ch.. (sem copia intermedia); retorna o n de blocos entregues
+int audio_capture_push_frames(int first_ch, const IngestFormat *fmt, const void *frames, int nframes);
+// N que o proximo bloco do canal entregue com sucesso vai receber
+// (so valido na thread que faz audio_capture_push, entre blocos completos)
+unsigned audio_capture_next_seq(int ch);
+
+// Espera ate haver menos de max_inflight blocos em uso na pool do canal
+// (fontes que nao sao tempo-real); retorna 0 se expirar o timeout
+int audio_capture_wait_space(int ch, int max_inflight, long timeout_ms);
+
+// NOTE - wrapper que liberta uma referencia do buffer do canal (lock-free)
+void audio_release_buffer(int ch, float *ptr);
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,73 @@
+#ifndef AUDIO_SOURCE_H
+#define AUDIO_SOURCE_H
+#include "ingest.h"
+
+// NOTE - Interface de fonte de audio
+// Todas as fontes entregam blocos pelo mesmo caminho (audio_capture_push),
+// por isso a pool, o dispatcher e os consumidores nao sabem de onde vem o audio
+// Cada canal do stream de origem e um canal do pipeline: a fonte ocupa os
+// canais first_channel..first_channel+channels-1 (varias fontes abertas ao
+// mesmo tempo ficam em canais seguidos)
+typedef struct AudioSource AudioSource;
+struct AudioSource
+{
+	const char *name;
+	int rate;	  // frequencia de amostragem entregue
+	int channels; // canais no stream de origem
+	int first_channel; // primeiro canal do pipeline (gChannels)
+	IngestFormat fmt;  // formato das amostras entregues (ingest.h)
+
+	int (*start)(AudioSource *s);
+	void (*stop)(AudioSource *s);
+	// 1 quando a fonte ja nao tem mais dados (fim do ficheiro)
+	int (*finished)(AudioSource *s);
+	void (*close)(AudioSource *s);
+};
+
+// Ritmo de entrega das fontes nao-SDL
+enum
+{
+	SOURCE_PACE_REALTIME = 0, // um bloco a cada ABUFSIZE_SAMPLES / rate segundos
+	SOURCE_PACE_FAST		  // tao rapido quanto os consumidores conseguem
+};
+
+// NOTE - Fonte SDL: dispositivo de captura (index < 0 pergunta ao utilizador)
+// com channels canais, a partir do canal first_channel
+AudioSource *audio_source_sdl_open(int index, int channels, int first_channel);
+
+// NOTE - Fonte ficheiro: WAV PCM 16/32 bits ou float 32 bits, ou raw S16LE mono (raw != 0)
+// O ficheiro e mapeado em memoria e entregue bloco a bloco por uma thread;
+// todos os canais do ficheiro sao analisados
+AudioSource *audio_source_file_open(const char *path, int raw, int pace, int first_channel);
+
+// NOTE - Fonte sintetica: sinal de motor com verdade de referencia conhecida
+typedef struct
+{
+	double f0_start, f0_end; // fundamental (Hz), rampa linear de f0_start a f0_end
+	double ramp_s;			 // duracao da rampa (s)
+	int harmonics;			 // n de harmonicas, incluindo a fundamental
+	double amp;				 // amplitude da fundamental (escala int16)
+	double harm_decay;		 // harmonica h tem amp * harm_decay^(h-1)
+	double fault_hz;		 // componente de falha de rolamento (0 = sem falha)
+	double fault_amp;		 // amplitude da falha relativa a fundamental
+	double fault_start_s;	 // instante em que a falha aparece
+	double noise;			 // desvio padrao do ruido gaussiano
+	int channels;			 // canais simulados (motor c roda a f0 * (1 + 0.05c))
+	double duration_s;		 // 0 = sem fim
+	double rate_mult;		 // ritmo: 1 = tempo real, 10 = 10x, 0 = tao rapido quanto possivel
+} SynthParams;
+
+// Valores por omissao
+void synth_params_default(SynthParams *p);
+// Altera p a partir de "chave=valor,..." (ver usage no main); -1 se invalido
+int synth_params_parse(SynthParams *p, const char *spec);
+AudioSource *audio_source_synth_open(const SynthParams *p, int first_channel);
+
+// NOTE - Verificação da exatidão contra a verdade de referencia
+// Os consumidores reportam as estimativas por canal e n de bloco; so a fonte
+// sintetica conhece a verdade, para os outros canais estas funcoes nao fazem nada
+void truth_report_speed(int ch, unsigned seq, float hz);
+void truth_report_fault(int ch, unsigned seq, int fault);
+void truth_print_summary(void);
+
+#endif
@@ -1,16 +1,10 @@
 #ifndef BEARING_H
 #define BEARING_H
-#include <pthread.h>
 #include "rtdb.h"
 
-// NOTE - Bearing Thread declaration 
-extern pthread_t bearing_th;
-// var de controlo do estado da thread
-extern volatile int bearing_run;
-
-// NOTE - Funcao da thread de bearing
-void *bearing_loop(void *arg);
-// Da ao modulo bearing a rtdb
-void bearing_set_rtdb(RTDB *db);
+// NOTE - Analise de Bearing
+// Corre como tarefa do runtime (runtime.h), um canal de cada vez.
+// Regista a analise e da-lhe a rtdb; retorna o indice da fila no canal
+int bearing_register(RTDB *db);
 
 #endif
@@ -1,19 +1,113 @@
 #ifndef BUFFER_H
 #define BUFFER_H
 #include <stdint.h>
+#include <stdatomic.h>
 #include "config.h"
+#include "notify.h"
+#include "ingest.h"
 
-// NOTE - Struct e inicialização do double buffer
+// NOTE - Pool de N blocos de audio com contagem de referencias
+// Substitui o double buffer bufA/bufB: cada bloco so volta a ficar livre
+// quando o ultimo consumidor subscrito o liberta
+// Os blocos circulam por dois aneis de indices, so com atomicos (nenhum
+// lado precisa do lock do dispositivo de audio):
+//  - livres: multi-produtor (quem liberta a ultima referencia, em qualquer
+//    thread) / consumidor unico (a captura)
+//  - cheios: produtor unico (a captura) / consumidor unico (o worker que
+//    despacha o canal), pela ordem de captura
+// Cada anel tem capacidade >= nslots e um bloco esta no maximo num deles,
+// por isso nunca enchem.
 
-// Estrutura dos novos buffers
+// Estados de um bloco
+enum
+{
+	BUF_FREE = 0,	// livre para a captura
+	BUF_FILLING,	// a ser preenchido pela captura
+	BUF_FULL,		// cheio, a espera do dispatcher
+	BUF_DISPATCHED	// entregue aos consumidores (refs > 0)
+};
+
+// Estrutura dos buffers
 typedef struct
 {
-	int16_t data[ABUFSIZE_SAMPLES]; // 4096 amostras por buffer
-	volatile int full;				// volatile para sincronização segura do valor entre threads
-	volatile int ready_to_consume;	// flag para indicar que o buffer está pronto para processamento
+	float *data;	  // ABUFSIZE_SAMPLES amostras float32 (escala int16), alinhado a cache line
+	int len;		  // numero de amostras validas
+	unsigned seq;	  // n do bloco, pela ordem de captura
+	uint64_t t_capture; // instante da captura (ns, CLOCK_MONOTONIC)
+	atomic_int state; // BUF_*
+	atomic_int refs;  // consumidores que ainda nao libertaram o bloco
 } AudioBuf;
 
-void buffer_init(AudioBuf *b);
-void buffer_release_nolock(int16_t *ptr, AudioBuf *a, AudioBuf *b);
+// Celula do anel dos livres (Vyukov): a celula da posicao pos esta livre
+// para escrita quando seq == pos e tem o slot quando seq == pos + 1
+typedef struct
+{
+	atomic_uint seq;
+	int slot;
+} BufFreeCell;
+
+typedef struct
+{
+	AudioBuf *slots;
+	float *mem;	   // memoria contigua de todos os blocos
+	int nslots;
+	int block_samples; // capacidade de cada bloco
+	int stride;		   // distancia entre blocos em mem (amostras)
+	unsigned ring_mask; // capacidade dos aneis - 1 (potencia de 2 >= nslots)
+
+	BufFreeCell *free_ring;
+	_Alignas(CACHE_LINE) atomic_uint free_head; // reservado por quem liberta
+	_Alignas(CACHE_LINE) unsigned free_tail;	   // so a captura
+
+	// Anel dos cheios (indices dos slots)
+	int *full_ring;
+	_Alignas(CACHE_LINE) atomic_uint full_head; // so a captura
+	_Alignas(CACHE_LINE) atomic_uint full_tail; // so o dispatcher do canal
+
+	// Estado da captura (so a thread que entrega o audio do canal)
+	_Alignas(CACHE_LINE) unsigned next_seq;
+	AudioBuf *filling; // bloco a ser preenchido (NULL = nenhum)
+	int fill;		   // amostras ja escritas nele (ou descartadas, se dropping)
+	int dropping;	   // 1: o bloco em curso perdeu-se (sem slot livre)
+
+	atomic_int nfree;
+	atomic_int free_lowwater;	 // minimo de slots livres observado
+	atomic_ulong captured;		 // blocos entregues ao dispatcher
+	atomic_ulong capture_drops;	 // blocos perdidos por nao haver slot livre
+
+	Notifier freed; // sinalizado quando um bloco volta a ficar livre
+} BufferPool;
+
+typedef struct
+{
+	int nslots;
+	int nfree;
+	int free_lowwater;
+	unsigned long captured;
+	unsigned long capture_drops;
+} BufferPoolStats;
+
+// Aloca nslots blocos de block_samples amostras; retorna -1 se falhar
+int buffer_pool_init(BufferPool *p, int nslots, int block_samples);
+void buffer_pool_destroy(BufferPool *p);
+
+// Lado da captura: reserva um slot livre (NULL e conta um drop se nao houver)
+AudioBuf *buffer_pool_acquire(BufferPool *p);
+// Lado da captura: marca o bloco como cheio com len amostras
+void buffer_pool_publish(BufferPool *p, AudioBuf *b, int len);
+// Lado da captura: converte n amostras de src (ingest.h) diretamente para os
+// blocos; cada bloco so e publicado quando tem block_samples amostras, as que
+// sobram ficam para a chamada seguinte. Retorna os blocos publicados
+int buffer_pool_write(BufferPool *p, IngestSrc *src, int n);
+
+// Lado do dispatcher: retira o bloco cheio mais antigo (NULL se nenhum)
+AudioBuf *buffer_pool_next_full(BufferPool *p);
+// Entrega o bloco a nrefs consumidores (com nrefs == 0 fica logo livre)
+void buffer_pool_dispatch(BufferPool *p, AudioBuf *b, int nrefs);
+
+// Liberta uma referencia do bloco que contem ptr
+void buffer_pool_release(BufferPool *p, const float *ptr);
+
+void buffer_pool_stats(BufferPool *p, BufferPoolStats *st);
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,57 @@
+#ifndef CHANNEL_H
+#define CHANNEL_H
+#include <stdatomic.h>
+#include "config.h"
+#include "buffer.h"
+#include "desc_queue.h"
+#include "spectrum.h"
+#include "iir.h"
+#include "decim.h"
+#include "goertzel.h"
+#include "notify.h"
+#include "runtime.h"
+
+// NOTE - Contexto de um canal (um motor)
+// Cada canal tem a sua pool de captura, o estado do filtro, do decimador e
+// do banco de Goertzel, a pool de espectros e uma fila por analise registada
+// no runtime. O estado de processamento e so escrito pelo worker que trata
+// o canal, por isso canais diferentes correm em paralelo sem partilhar nada.
+// O indice do canal e tambem o slot na RTDB.
+typedef struct
+{
+	int id;
+	int worker;		// worker do runtime que despacha o canal
+	Notifier *wake; // notifier desse worker (sinalizado pela captura)
+
+	BufferPool pool; // blocos capturados
+	IngestDC dc;	 // DC tirado na ingestao (so a thread da captura)
+
+	// Passa-baixo com estado continuo entre blocos; o resultado vai para outro
+	// buffer e o bloco capturado (float32, ja sem DC) fica intacto na pool
+	IIRFilter lpf;
+	float *filtered; // ABUFSIZE_SAMPLES
+	// Decimacao e janela deslizante das analises (ANALYSIS_N amostras da taxa baixa)
+	Decimator decim;
+	float *lowrate;	 // ABUFSIZE_SAMPLES / DECIM_FACTOR + 1
+	float *analysis; // ANALYSIS_N
+	// Detetor do bearing por Goertzel, atualizado a cada bloco
+	BearingBank bbank;
+	SpectrumPool spec;
+
+	// Filas de descritores, uma por analise (indice de runtime_register)
+	DescQueue q[RUNTIME_MAX_ANALYSES];
+
+	_Alignas(CACHE_LINE) atomic_int blocks; // blocos despachados
+	// 1 enquanto a tarefa (analise, canal) esta num deque ou a correr
+	atomic_int active[RUNTIME_MAX_ANALYSES];
+} Channel;
+
+extern Channel *gChannels;
+extern int gNumChannels;
+
+// Cria n canais (1..MAX_CHANNELS) com pools de pool_slots blocos;
+// retorna -1 se falhar
+int channels_init(int n, int pool_slots);
+void channels_destroy(void);
+
+#endif
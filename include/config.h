@@ -11,14 +11,103 @@
 
 #define MONO 1
 #define SAMP_FREQ 44100
+// Formato pedido ao dispositivo; o obtido pode ser outro (ingest.h converte
+// U16, S16, S32 e F32 em qualquer endianness)
 #define FORMAT AUDIO_U16
 #define ABUFSIZE_SAMPLES 4096
+// n maximo de canais (motores) analisados, somando todas as fontes
+#define MAX_CHANNELS 16
+// workers do runtime (runtime.h), fixados a cores: despacham os canais
+// (c % n) e correm as tarefas das analises, roubando-as uns aos outros
+// 0 = um por core disponivel, ate ao n de canais; opcao -w em runtime
+#define DISPATCH_WORKERS 0
+// n de blocos na pool de captura de cada canal (ver stats de low-water no fim da execucao)
+#define AUDIO_POOL_SLOTS 16
 // Frequencia de corte do lpf
 #define CUTOFF_HZ 1000
-// limite maximo de frequencia util para o calculo do speed
-#define MAX_USEFUL_FREQ 10000
+// Ordem do passa-baixo Butterworth do dispatcher (secoes biquad = ordem / 2)
+#define LPF_ORDER 4
+// Decimacao depois do passa-baixo (FIR polifasico, decim.h)
+// A taxa baixa e SAMP_FREQ / DECIM_FACTOR (8 -> 5512.5 Hz, Nyquist 2756 Hz)
+#define DECIM_FACTOR 8
+#define DECIM_TAPS_PER_PHASE 16
+// corte do FIR em fracao do Nyquist da taxa baixa
+#define DECIM_CUTOFF 0.8
+// Janela do espectro (speed) em amostras da taxa baixa, potencia de 2
+// 256 a 5512.5 Hz: 46 ms (2048 amostras a 44.1 kHz) e 21.5 Hz por bin;
+// a interpolacao do pico (SPEED_PEAK_METHOD) da a resolucao abaixo do Hz
+#define ANALYSIS_N 256
+#define ANALYSIS_FS ((float)SAMP_FREQ / DECIM_FACTOR)
+// Fim da banda de passagem do decimador (DECIM_CUTOFF do Nyquist da taxa
+// baixa: 2205 Hz); acima disso os bins so tem a transicao do FIR
+#define ANALYSIS_MAX_HZ ((float)(DECIM_CUTOFF * ANALYSIS_FS / 2))
+// Estimador do pico do speed (peak.h): PEAK_BIN, PEAK_PARABOLIC, PEAK_GAUSSIAN, PEAK_JACOBSEN
+#define SPEED_PEAK_METHOD PEAK_JACOBSEN
+// Refinamento com zoom (DTFT com passo 1/SPEED_ZOOM bin a volta do pico), 0 = desligado
+#define SPEED_ZOOM 0
+// Seguimento do speed (speed_track.h): procura do pico so nos bins da FFT
+// a volta da ultima estimativa, com a mesma interpolacao; ignora picos fora
+// da banda, nao aumenta a resolucao. 1 = ligado; banda de 80 Hz (~4 bins)
+#define SPEED_TRACK 1
+#define SPEED_TRACK_SPAN_HZ 80.0f
+// perde o lock se a amplitude do pico cair abaixo desta fracao da media
+#define SPEED_TRACK_LOCK_RATIO 0.5f
+// procura completa periodica (ciclos), para apanhar um pico maior fora da banda
+#define SPEED_TRACK_REACQUIRE 16
+// Janela do detetor do bearing na taxa baixa: a resolucao das LF (5.4 Hz por bin)
+#define BEARING_N 1024
+// Limiares do bearing: banda do motor (ate ao fim da banda de passagem da
+// taxa baixa), banda LF das falhas e amplitude relativa do pico LF ao pico
+// do motor
+#define BEARING_MOTOR_MIN 200.0f
+#define BEARING_MOTOR_MAX ANALYSIS_MAX_HZ
+#define BEARING_LOWF_TH 150.0f
+#define BEARING_REL_TH 0.25f
+// O pico da banda do motor (FFT de BEARING_N pontos) e recalculado ao ritmo
+// da decisao do bearing e nao a cada bloco; os bins LF seguem cada bloco
+#define BEARING_MOTOR_PERIOD_MS 1000
+// limite maximo de frequencia util para o calculo do speed (o espectro e o
+// da taxa baixa: nada acima da banda de passagem do decimador)
+#define MAX_USEFUL_FREQ ANALYSIS_MAX_HZ
 
 
+// capacidade por omissao das filas do dispatcher (arredondada a potencia de 2)
 #define DESCRIPTOR_QUEUE_CAPACITY 8
+// Ativacao das threads: 0 = por eventos (acordam quando chega trabalho)
+// 1 = periodico (polling com periodo fixo, para analise de escalonamento)
+// Pode ser alterado em runtime com a opcao -p
+#define PERIODIC_MODE_DEFAULT 0
+// timeout das esperas no modo por eventos (para verificar as flags de run)
+#define WAIT_TIMEOUT_MS 100
+// tamanho da cache line, para separar dados escritos por threads diferentes
+#define CACHE_LINE 64
+// n de espectros em circulação por canal (descritores nas filas + em processamento)
+#define SPECTRUM_POOL_SIZE (2 * DESCRIPTOR_QUEUE_CAPACITY + 2)
+// valores guardados por campo e por canal na RTDB (potencia de 2)
+#define RTDB_HISTORY 64
+// tentativas de uma leitura da RTDB antes de desistir (escritor a meio de
+// uma escrita ou morto com seq impar, na memoria partilhada)
+#define RTDB_READ_RETRIES 1000
+// log assincrono (rtlog.h): registos no anel (potencia de 2), periodo da
+// drenagem e limite de registos por segundo de cada nivel (0 = sem limite)
+#define RTLOG_RING_SIZE 4096
+#define RTLOG_DRAIN_MS 10
+#define RTLOG_RATE_DEBUG 2000
+#define RTLOG_RATE_INFO 1000
+#define RTLOG_RATE_WARN 0
+#define RTLOG_RATE_ERROR 0
+// telemetria (telemetry.h): registos por chunk, anel de cada canal (potencia
+// de 2), periodo da thread de escrita e idade maxima de um chunk incompleto
+#define TELEM_CHUNK_RECORDS 4096
+#define TELEM_RING 1024
+#define TELEM_POLL_MS 50
+#define TELEM_FLUSH_MS 1000
+// gravacao do audio a volta das falhas (rawrec.h): audio antes e depois da
+// transicao e periodo da thread de escrita
+#define RAWREC_PRE_MS 5000
+#define RAWREC_POST_MS 2000
+#define RAWREC_POLL_MS 50
+// constante de tempo da estimativa do DC tirado na ingestao (ingest.h)
+#define INGEST_DC_TAU_MS 1000
 
 #endif
\ No newline at end of file
@@ -0,0 +1,15 @@
+#ifndef CPU_UTILS_H
+#define CPU_UTILS_H
+
+// NOTE - Pausa dentro das esperas ativas (spin)
+// Liberta o core irmao (SMT) e evita o flush do pipeline ao sair do ciclo
+static inline void cpu_relax(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef DECIM_H
+#define DECIM_H
+
+// NOTE - Decimador FIR polifasico (fator M)
+// O filtro anti-aliasing h de M*L coeficientes e dividido em M fases
+// e_p[j] = h[j*M + p]; o comutador distribui a entrada pelas fases
+// (x_p[m] = x[m*M + M-1 - p]) e cada saida e a soma das M sub-filtragens
+// de L coeficientes. So se calculam as amostras que ficam, ou seja
+// L*M produtos por saida em vez de L*M por entrada.
+// As linhas de atraso de cada fase continuam de um bloco para o seguinte,
+// e os blocos nao precisam de ser multiplos de M.
+
+#define DECIM_MAX_FACTOR 16
+#define DECIM_VEC 8 // saidas calculadas em conjunto (L tem de ser multiplo)
+
+typedef struct Decimator Decimator;
+struct Decimator
+{
+	int M;			// fator de decimacao
+	int L;			// coeficientes por fase
+	float *h;		// h[p*L + t] = e_p[L-1-t] (fase p invertida)
+	float *buf;		// linhas de atraso das fases (stride floats cada)
+	int stride;
+	int cnt[DECIM_MAX_FACTOR]; // amostras em cada linha (L-1 de historia + novas)
+	int pos;		// amostras ja recebidas da trama atual (0..M-1)
+	int max_in;		// maior bloco de entrada aceite
+	// Sub-filtragens (generico ou AVX2+FMA, escolhido via CPUID em decim_init)
+	void (*run)(const Decimator *d, float *y, int nout);
+};
+
+// Passa-baixo de M*L coeficientes (sinc com janela Blackman) com corte em
+// cutoff * fs_saida / 2 (cutoff em ]0, 1]); blocos de ate max_in amostras
+// Retorna -1 se os parametros forem invalidos ou faltar memoria
+int decim_init(Decimator *d, int M, int L, double cutoff, int max_in);
+void decim_destroy(Decimator *d);
+// Repoe as linhas de atraso a zero
+void decim_reset(Decimator *d);
+
+// Decima n amostras de x para y; retorna o n de saidas (ate n/M + 1)
+int decim_process(Decimator *d, const float *x, int n, float *y);
+
+// Ganho |H(f)| do filtro anti-aliasing a taxa de entrada fs (para verificacao)
+double decim_gain(const Decimator *d, double freq, double fs);
+
+#endif
@@ -1,29 +1,82 @@
 #ifndef DESC_QUEUE_H
 #define DESC_QUEUE_H
-#include <pthread.h>
+#include <stdatomic.h>
 #include <stdint.h>
 #include "config.h"
+#include "spectrum.h"
+#include "notify.h"
 
 // NOTE - Descritor para as filas do dispatcher
 typedef struct
 {
-	int16_t *ptr; // ponteiro para os dados do buffer cheio
-	int len;	  // numero de amostras
+	float *ptr;		// ponteiro para os dados do buffer cheio
+	int ch;			// canal do bloco (gChannels, slot da RTDB)
+	int len;		// numero de amostras
+	unsigned seq;	// n do bloco, pela ordem de captura
+	Spectrum *spec; // espectro do bloco (partilhado, pode ser NULL)
+	int fault;		// decisao do banco de Goertzel do bearing (goertzel.h)
+	float lf_peak, motor_peak; // amplitudes do banco nesse bloco (telemetria)
+	uint64_t t_capture; // instante da captura do bloco (ns)
+	uint64_t t_dispatch; // inicio do dispatch do bloco (ns)
+	uint64_t t_ready;	// instante da publicacao na fila (ns)
 } AudioDesc;
 
 // NOTE - Estrutura para as filas do dispatcher
 // O dispatcher contem uma fila para cada thread dedicada compostas pelos descritores
+// Fila lock-free single-producer/single-consumer (anel com indices atomicos):
+// - head so e escrito pelo produtor (dispatcher)
+// - tail e avancado por CAS pelo consumidor (pop) e pelo produtor quando a fila
+//   esta cheia e descarta o descritor mais antigo (mesma semantica de antes)
+// Os indices crescem sempre (mod 2^32) e cada um fica na sua cache line
+// para o produtor e o consumidor nao invalidarem a linha um do outro
+// Cada slot tem um seq (como na fila de Vyukov): quem avanca o tail fica
+// dono da posicao e so depois copia o descritor; o slot volta a ser do
+// produtor quando a copia acaba (seq = pos + capacity). Assim a copia do
+// consumidor nunca corre ao mesmo tempo que uma escrita do produtor.
 typedef struct
 {
-	AudioDesc desc[DESCRIPTOR_QUEUE_CAPACITY];
-	int head;
-	int tail;
-	int count;
-	pthread_mutex_t mtx;
+	atomic_uint seq; // pos + 1: descritor da posicao pos publicado; pos: livre para pos
+	AudioDesc d;
+} DescCell;
+
+typedef struct
+{
+	_Alignas(CACHE_LINE) atomic_uint head; // proximo slot a escrever
+	atomic_ulong dropped;					// descritores descartados por overwrite
+
+	_Alignas(CACHE_LINE) atomic_uint tail; // proximo slot a ler
+
+	_Alignas(CACHE_LINE) Notifier ready; // sinalizado a cada push (modo por eventos)
+	Notifier *wake;						  // notifier sinalizado (&ready ou partilhado)
+
+	_Alignas(CACHE_LINE) DescCell *desc; // capacity slots
+	unsigned capacity;						// potencia de 2
+	unsigned mask;							// capacity - 1
+	atomic_int subscribed;					// 1 quando existe uma thread a consumir a fila
 } DescQueue;
 
-void desc_queue_init(DescQueue *q);
-int desc_queue_push(DescQueue *q, AudioDesc d);
+// capacity e arredondada para a potencia de 2 seguinte; retorna -1 se falhar
+int desc_queue_init(DescQueue *q, int capacity);
+void desc_queue_destroy(DescQueue *q);
+// Retorna 0 se a fila estava cheia e o descritor mais antigo foi descartado
+// (copiado para *dropped se != NULL, para o dispatcher libertar o espectro)
+// So pode ser chamada pelo produtor
+int desc_queue_push(DescQueue *q, AudioDesc d, AudioDesc *dropped);
+// Nunca bloqueia; retorna 0 se a fila estiver vazia
 int desc_queue_pop(DescQueue *q, AudioDesc *out);
+// Pop que espera por um push ate timeout_ms (sem locks, via futex)
+// Retorna 0 se a fila continuar vazia no fim do timeout
+int desc_queue_pop_wait(DescQueue *q, AudioDesc *out, long timeout_ms);
+// Pop que tenta as n filas a partir de *next (round-robin, *next avanca)
+// Retorna o indice da fila ou -1 se estiverem todas vazias
+int desc_queue_pop_any(DescQueue *const *qs, int n, int *next, AudioDesc *out);
+// Chamada pela thread consumidora antes de comecar a consumir
+// wake: notifier a sinalizar nos push em vez do da fila (NULL = o da fila),
+// para uma thread esperar por varias filas
+void desc_queue_subscribe(DescQueue *q, Notifier *wake);
+// Descritores na fila (aproximado se houver pops em paralelo)
+unsigned desc_queue_size(DescQueue *q);
+// N total de descritores descartados desde o init
+unsigned long desc_queue_dropped(DescQueue *q);
 
-#endif
\ No newline at end of file
+#endif
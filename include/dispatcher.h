@@ -1,22 +1,25 @@
 #ifndef DISPATCHER_H
 #define DISPATCHER_H
-#include <pthread.h>
 #include "desc_queue.h"
+#include "channel.h"
 
-// Variável de controlo do estado da thread
-// extern para partilhar a mesma variavel global entre os modulos
-extern volatile int dispatcher_run;
-extern pthread_t dispatcher_th;
+// Modo de ativacao das threads (ver PERIODIC_MODE_DEFAULT em config.h)
+extern int periodic_mode;
 
-void *dispatcher_loop(void *arg);
+// NOTE - Estagio de dispatch de um canal
+// Corre nos workers do runtime (runtime.h): cada canal e despachado sempre
+// pelo mesmo worker, que filtra, decima, calcula o espectro e o banco de
+// Goertzel e publica o descritor na fila de cada analise registada.
+// Como o estado de um canal so e tocado pelo seu worker, os canais escalam
+// com o n de cores.
+// Chamada pelo main depois de channels_init
+int dispatcher_init(void);
+// Despacha o bloco cheio mais antigo do canal; retorna 0 se nao havia nenhum
+int dispatcher_dispatch(Channel *c);
 
-// NOTE - Getters para as filas do dispatcher
-// Servem para que as threads consumidoras acedam às respetivas filas do dispatcher
-DescQueue *dispatcher_get_speed_queue(void);
-DescQueue *dispatcher_get_bearing_queue(void);
-DescQueue *dispatcher_get_direction_queue(void);
-
-// contador de blocos para critério de paragem
+// contador de blocos para critério de paragem (o do canal mais atrasado)
 int dispatcher_blocks_count(void);
+// blocos despachados em todos os canais
+int dispatcher_blocks_total(void);
 
-#endif
\ No newline at end of file
+#endif
@@ -18,6 +18,9 @@
  
  * ************************************************************/
 
+#ifndef FFT_H
+#define FFT_H
+
 #include <math.h>
 #include <complex.h>
 
@@ -30,6 +33,50 @@
  * *******************************************************************/
 void fftCompute(complex double *X, int N);
 
+/* *******************************************************************
+ * FFT plan (iterative, in-place version)
+ * The twiddle factors and the bit-reversal permutation are computed
+ * once per size by fftPlanCreate(). fftPlanExecute() then runs the
+ * transform in place with radix-4 passes (plus one radix-2 pass when
+ * log2(N) is odd), without allocating memory or calling cexp().
+ * The plan is read-only after creation, so it may be shared by
+ * several threads. fftCompute() is kept as the reference version.
+ * 		int N: the number of elements. *** MUST BE A POWER OF 2 ****
+ * *******************************************************************/
+typedef struct {
+	int N;
+	int log2N;
+	int *rev;				/* bit-reversal permutation, N entries */
+	complex double *tw;		/* W_N^k = exp(-2*pi*i*k/N), k = 0..N/2-1 */
+} FFTPlan;
+
+/* Returns NULL if N is not a power of 2 or on allocation failure */
+FFTPlan *fftPlanCreate(int N);
+void fftPlanExecute(const FFTPlan *p, complex double *X);
+void fftPlanDestroy(FFTPlan *p);
+
+/* *******************************************************************
+ * Real-input FFT
+ * The N real samples are packed as N/2 complex numbers
+ * (z[n] = x[2n] + i*x[2n+1]), transformed with a complex plan of size
+ * N/2 and then split into the spectrum of x. Only the non-mirrored
+ * bins 0..N/2 are returned, so the work and the memory are about half
+ * of those of a complex FFT of size N.
+ * 	Args:
+ * 		const double *x: the N real input samples
+ * 		complex double *Y: output, N/2+1 bins (DC to fs/2)
+ * 		int N: the number of samples. *** MUST BE A POWER OF 2, >= 2 ****
+ * *******************************************************************/
+typedef struct {
+	int N;
+	FFTPlan *half;			/* complex plan of size N/2 */
+	complex double *tw;		/* W_N^k, k = 0..N/4 */
+} FFTRealPlan;
+
+FFTRealPlan *fftRealPlanCreate(int N);
+void fftRealExecute(const FFTRealPlan *p, const double *x, complex double *Y);
+void fftRealPlanDestroy(FFTRealPlan *p);
+
 /* **********************************************************
  *  Converts complex representation of FFT in amplitudes.
  *  Also generates the corresponding frequencies
@@ -42,6 +89,16 @@ void fftCompute(complex double *X, int N);
  * **********************************************************/
 void fftGetAmplitude(complex double * X, int N, int fs, float * fk, float * Ak);
 
+/* **********************************************************
+ *  Same as fftGetAmplitude, for the output of fftRealExecute
+ * 	Args:
+ * 		const complex double Y: the N/2+1 bins
+ * 		int N: number of real samples transformed
+ * 		int fs: sampling frequency (in Hz)
+ * 		float *fk, *Ak: N/2+1 frequencies and amplitudes
+ * **********************************************************/
+void fftGetAmplitudeReal(const complex double *Y, int N, int fs, float *fk, float *Ak);
+
 /* ******************************************************
  *  Helper function to print complex arrays
  * 	Args:
@@ -49,3 +106,5 @@ void fftGetAmplitude(complex double * X, int N, int fs, float * fk, float * Ak);
  * 		int N: length of the array
  * ******************************************************/
 void printComplexArray(complex double *X, int N);
+
+#endif
@@ -0,0 +1,69 @@
+#ifndef FFTF_H
+#define FFTF_H
+#include <stdint.h>
+
+/* *******************************************************************
+ * FFT real em float32 com kernels vetorizados (SSE2 / AVX2)
+ *
+ * Os dados de 16 bits nao precisam de precisao double: o plan guarda
+ * o espectro em formato "split" (re[] e im[] separados), o que permite
+ * processar 4 (SSE2) ou 8 (AVX2) butterflies por instrucao.
+ * A variante dos kernels e escolhida no arranque via CPUID, com uma
+ * versao escalar portavel como fallback.
+ * *******************************************************************/
+
+// NOTE - Tabela de kernels de uma variante (escalar, SSE2, AVX2)
+typedef struct
+{
+	const char *name;
+	int width; // m minimo tratado por fft_pass (estagios menores usam o escalar)
+	// Um estagio radix-2 (DIT) de meia dimensao m sobre M pontos
+	// tw_re/tw_im: W_2m^j, j = 0..m-1
+	void (*fft_pass)(float *re, float *im, const float *tw_re, const float *tw_im,
+					 int M, int m);
+	// out[k] = scale * |re[k] + i*im[k]|, k = 0..n-1
+	void (*magnitude)(const float *re, const float *im, float *out, int n, float scale);
+	// Indice do maximo de x[begin..end-1] (o primeiro em caso de empate), -1 se vazio
+	int (*peak)(const float *x, int begin, int end);
+} FFTFKernels;
+
+typedef enum
+{
+	FFTF_ISA_SCALAR = 0,
+	FFTF_ISA_SSE2,
+	FFTF_ISA_AVX2,
+	FFTF_ISA_COUNT
+} FFTFIsa;
+
+// Kernels de uma variante, NULL se nao compilada ou nao suportada pelo CPU
+const FFTFKernels *fftfKernels(FFTFIsa isa);
+// Melhor variante suportada (escolhida via CPUID na primeira chamada)
+const FFTFKernels *fftfBestKernels(void);
+
+// NOTE - Plan da FFT real de N pontos (N potencia de 2, >= 4)
+// Os buffers de trabalho pertencem ao plan: um plan por thread
+typedef struct
+{
+	int N;			// n de amostras reais
+	int M;			// N/2, tamanho da FFT complexa interna
+	int *rev;		// permutacao bit-reversal (M entradas)
+	float *tw_re;	// twiddles por estagio, o estagio m ocupa [m..2m-1] (alinhados)
+	float *tw_im;
+	float *sp_re;	// W_N^k, k = 0..M/2, para separar o espectro real
+	float *sp_im;
+	float *re;		// resultado: bins 0..M (M+1 entradas, alinhado a 32 bytes)
+	float *im;
+	const FFTFKernels *k;
+} FFTFPlan;
+
+// k == NULL usa fftfBestKernels()
+FFTFPlan *fftfPlanCreate(int N, const FFTFKernels *k);
+void fftfPlanDestroy(FFTFPlan *p);
+
+// FFT real de x (N amostras); bins 0..N/2 ficam em p->re / p->im
+void fftfRealExecute(FFTFPlan *p, const float *x);
+
+// Amplitudes dos bins 0..N/2 (escala 2*gain para os bins interiores, gain para DC e fs/2)
+void fftfAmplitude(const FFTFPlan *p, float *amp, float gain);
+
+#endif
@@ -0,0 +1,83 @@
+#ifndef GOERTZEL_H
+#define GOERTZEL_H
+#include "decim.h"
+#include "fftf.h"
+
+// NOTE - Banco de Goertzel: so os bins de interesse de uma DFT de N pontos
+// Cada bin k e uma recorrencia de 2a ordem s = x + 2cos(2 pi k/N) s1 - s2
+// sobre a janela (Hann, como o spectrum); no fim
+// |X_k|^2 = s1^2 + s2^2 - 2cos(2 pi k/N) s1 s2.
+// Os bins correm em paralelo nas lanes de um vetor (extensoes do GCC),
+// o custo e proporcional a n de bins * N em vez de N log N para todos.
+// As amplitudes tem a mesma escala que spectrum_compute.
+
+#define GOERTZEL_VEC 8
+
+typedef struct GoertzelBank GoertzelBank;
+struct GoertzelBank
+{
+	int N;			// tamanho da janela
+	int k0, nb;		// bins k0 .. k0+nb-1
+	int nv;			// vetores de GOERTZEL_VEC bins
+	float *coef;	// 2cos(2 pi k / N) (nv*GOERTZEL_VEC, os extra com k = k0)
+	float *window;	// Hann de N pontos
+	float *xw;		// janela aplicada (trabalho)
+	float *amp;		// amplitudes dos bins (nv*GOERTZEL_VEC)
+	float gain;		// 1 / soma da janela
+	// Recorrencias (generico ou AVX2+FMA, escolhido via CPUID em goertzel_init)
+	void (*run)(GoertzelBank *b);
+};
+
+// Bins [k0, k1) de uma DFT de N pontos; retorna -1 se invalido ou sem memoria
+int goertzel_init(GoertzelBank *b, int N, int k0, int k1);
+void goertzel_destroy(GoertzelBank *b);
+// Amplitudes dos bins para as N amostras de x
+void goertzel_compute(GoertzelBank *b, const float *x);
+// Indice (relativo a k0) do maior bin calculado, -1 se vazio
+int goertzel_peak(const GoertzelBank *b);
+
+// NOTE - Detetor de falhas de rolamentos com dois bancos
+// Mesma decisao que compute_bearing_issue_freq: pico LF (f < lowf_th) acima
+// de rel_th vezes o pico da banda do motor, com a mesma resolucao (fs/N)
+// e os mesmos limites das bandas.
+// Recebe as amostras novas de cada bloco e mantem as suas janelas:
+//  - banda LF: o sinal e decimado outra vez por BEARING_BANK_LF_DECIM e a
+//    janela tem N/BEARING_BANK_LF_DECIM amostras (mesma duracao, mesmos bins)
+//  - banda do motor: as N amostras (com menos pontos os bins alargam e o
+//    limite inferior da banda desloca-se, a decisao deixava de ser a mesma).
+//    A banda tem centenas de bins, por isso usa a FFT real (fftf.h) de N
+//    pontos em vez do Goertzel, que so compensa com poucos bins. A FFT so
+//    corre a cada BEARING_MOTOR_PERIOD_MS de sinal (e enquanto a janela
+//    enche): entre elas a decisao de cada bloco usa o ultimo pico do motor
+#define BEARING_BANK_LF_DECIM 8
+
+typedef struct
+{
+	GoertzelBank lf;
+	FFTFPlan *motor_plan;	// FFT real de N pontos
+	float *motor_window;	// Hann de N pontos (a mesma do spectrum)
+	float *motor_amp;		// amplitudes dos bins 0..N/2
+	float motor_gain;		// 1 / soma da janela
+	int motor_k0, motor_k1;	// bins [k0, k1) da banda do motor
+	int motor_every;		// amostras entre FFTs do motor
+	int motor_since;		// amostras desde a ultima FFT do motor
+	int motor_fill;			// amostras na janela (ate N)
+	Decimator decim;		// fs -> fs / BEARING_BANK_LF_DECIM
+	float *lf_win;			// ultimas lf.N amostras decimadas
+	float *motor_win;		// ultimas N amostras
+	float *motor_xw;		// motor_win com janela (trabalho)
+	float *tmp;				// saida do decimador
+	float rel_th;
+	float lf_peak, motor_peak; // ultimas amplitudes (diagnostico)
+} BearingBank;
+
+// N: janela equivalente das analises a taxa fs (multiplo de BEARING_BANK_LF_DECIM);
+// blocos de ate max_in amostras
+int bearing_bank_init(BearingBank *b, int N, float fs, int max_in,
+					  float motor_min_hz, float motor_max_hz,
+					  float low_freq_thresh_hz, float rel_amp_thresh);
+void bearing_bank_destroy(BearingBank *b);
+// Junta n amostras novas (taxa fs) e decide; retorna 1 se fault-like
+int bearing_bank_update(BearingBank *b, const float *x, int n);
+
+#endif
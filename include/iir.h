@@ -0,0 +1,77 @@
+#ifndef IIR_H
+#define IIR_H
+#include <stdint.h>
+
+// NOTE - Filtro IIR em cascata de biquads, com estado entre blocos
+// Os coeficientes sao calculados uma vez (iir_design_*) e o estado de cada
+// secao continua de um bloco para o seguinte, sem descontinuidades.
+//
+// Processamento paralelo por segmentos: o bloco e dividido em IIR_LANES
+// segmentos consecutivos e cada segmento corre numa lane de um vetor
+// (extensoes vetoriais do GCC), com a recorrencia normal das secoes.
+// O estado inicial de cada segmento e obtido antes, sem filtrar:
+//   s[k+1] = A^m s[k] + g[k]
+// onde g[k] e o estado final do segmento k com estado inicial zero,
+// um produto interno com os vetores A^j B precalculados (iir_set_block).
+// As secoes correm aos pares: o par e um sistema de 4 estados, o que
+// deixa duas cadeias de dependencias independentes no mesmo ciclo.
+// O resultado e o da recorrencia sequencial (a menos de arredondamentos).
+
+#define IIR_MAX_SECTIONS 8
+#define IIR_VEC 8					  // lanes por vetor
+#define IIR_NV 2					  // vetores por linha (cadeias independentes)
+#define IIR_LANES (IIR_VEC * IIR_NV) // n de segmentos por bloco
+#define IIR_GROUP 2					  // secoes processadas em conjunto
+
+typedef float iir_vf __attribute__((vector_size(IIR_VEC * sizeof(float))));
+
+typedef struct
+{
+	// Coeficientes normalizados (a0 = 1), forma direta II transposta
+	float b0, b1, b2, a1, a2;
+	float s1, s2; // estado (persistente entre blocos)
+} IIRBiquad;
+
+// Grupo de ns secoes consecutivas (estado de dimensao 2*ns)
+typedef struct
+{
+	int first, ns;
+	float Am[2 * IIR_GROUP][2 * IIR_GROUP]; // A^m do grupo
+	float *g[2 * IIR_GROUP];				// g[d][i] = (A^(m-1-i) B)[d], i = 0..m-1
+} IIRGroup;
+
+typedef struct IIRFilter IIRFilter;
+struct IIRFilter
+{
+	int nsec;
+	IIRBiquad sec[IIR_MAX_SECTIONS];
+	int block_n; // tamanho de bloco preparado (0 = so o caminho escalar)
+	int ngroups;
+	IIRGroup grp[(IIR_MAX_SECTIONS + IIR_GROUP - 1) / IIR_GROUP];
+	iir_vf *work; // bloco transposto: work[i*IIR_NV + v] = amostra i dos segmentos v*IIR_VEC..
+	// Caminho vetorial (generico ou AVX2+FMA, escolhido via CPUID em iir_set_block)
+	// A entrada e in16 (S16) ou inf (float); out pode ser igual a inf
+	void (*run_block)(IIRFilter *f, const int16_t *in16, const float *inf, float *out);
+};
+
+// Passa-baixo Butterworth de ordem order (1..2*IIR_MAX_SECTIONS) por transformada bilinear
+// Retorna -1 se os parametros forem invalidos
+int iir_design_butter_lp(IIRFilter *f, int order, double fc, double fs);
+// Prepara o caminho vetorial para blocos de n amostras (n multiplo de 8*IIR_LANES)
+// Blocos de outro tamanho usam a recorrencia escalar; retorna -1 se falhar
+int iir_set_block(IIRFilter *f, int n);
+void iir_destroy(IIRFilter *f);
+// Repoe o estado a zero
+void iir_reset(IIRFilter *f);
+
+// Filtra n amostras S16 para out (float, escala int16); o bloco original fica intacto
+void iir_process_s16(IIRFilter *f, const int16_t *in, float *out, int n);
+// Filtra n amostras float de in para out; in fica intacto
+void iir_process_f32(IIRFilter *f, const float *in, float *out, int n);
+// Filtra x in place
+void iir_process(IIRFilter *f, float *x, int n);
+
+// Ganho |H(f)| do filtro (para verificacao)
+double iir_gain(const IIRFilter *f, double freq, double fs);
+
+#endif
@@ -0,0 +1,90 @@
+#ifndef INGEST_H
+#define INGEST_H
+#include <stdint.h>
+
+// NOTE - Estagio de ingestao
+// Converte as tramas intercaladas de uma fonte (U16, S16, S32 ou F32, em
+// qualquer endianness e n de canais) para os blocos float32 da pool, numa
+// so passagem por canal: leitura, troca de bytes, conversao para a escala
+// int16 (as amplitudes e os limiares das analises nao mudam) e remocao do DC.
+// A mesma passagem soma as amostras para a estimativa do DC seguinte.
+// O kernel (vetores de 8 floats, generico ou AVX2) e escolhido via CPUID.
+
+typedef enum
+{
+	INGEST_U16 = 0, // sem sinal, zero em 32768
+	INGEST_S16,
+	INGEST_S32,		// escala int16: / 65536
+	INGEST_F32		// escala int16: * 32768
+} IngestType;
+
+// 1 se a maquina for big-endian (formato nativo das fontes que geram amostras)
+#define INGEST_HOST_BE (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+
+typedef struct IngestFormat IngestFormat;
+struct IngestFormat
+{
+	IngestType type;
+	int big_endian;
+	int channels;	  // canais intercalados em cada trama
+	int sample_bytes;
+	int frame_bytes;
+	const char *kernel; // kernel escolhido no init
+	// n amostras do canal k a partir de frames: dst[i] = x[i] - dc
+	// Retorna a soma dos x[i] (antes de tirar o DC)
+	float (*run)(const IngestFormat *f, const uint8_t *frames, int k, float *dst, int n, float dc);
+};
+
+// Retorna -1 se os parametros forem invalidos
+int ingest_format_init(IngestFormat *f, IngestType type, int big_endian, int channels);
+// Nome curto do formato (ex.: "S16LE")
+const char *ingest_format_name(const IngestFormat *f);
+
+// NOTE - Leitura de um canal de um pedaco de tramas
+// Cursor usado pela pool (buffer_pool_write): os blocos podem acabar a meio
+// do pedaco, a leitura continua onde ficou
+typedef struct
+{
+	const IngestFormat *fmt;
+	const uint8_t *p; // proxima trama
+	int k;			  // canal dentro da trama
+	float dc;		  // DC subtraido a todas as amostras do pedaco
+	double sum;		  // soma das amostras lidas
+	long n;			  // n de amostras lidas
+} IngestSrc;
+
+static inline void ingest_src_init(IngestSrc *s, const IngestFormat *f, const void *frames, int k, float dc)
+{
+	s->fmt = f;
+	s->p = frames;
+	s->k = k;
+	s->dc = dc;
+	s->sum = 0.0;
+	s->n = 0;
+}
+
+static inline void ingest_read(IngestSrc *s, float *dst, int n)
+{
+	s->sum += s->fmt->run(s->fmt, s->p, s->k, dst, n, s->dc);
+	s->n += n;
+	s->p += (long)n * s->fmt->frame_bytes;
+}
+
+// Amostras perdidas (sem bloco livre): nao entram na estimativa do DC
+static inline void ingest_skip(IngestSrc *s, int n)
+{
+	s->p += (long)n * s->fmt->frame_bytes;
+}
+
+// NOTE - DC de um canal
+// Media exponencial das medias dos pedacos lidos, com constante de tempo
+// INGEST_DC_TAU_MS; o primeiro pedaco fixa logo o DC (offset dos U16)
+typedef struct
+{
+	float dc;
+	int primed;
+} IngestDC;
+
+void ingest_dc_update(IngestDC *d, const IngestSrc *s, float fs);
+
+#endif
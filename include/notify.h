@@ -0,0 +1,25 @@
+#ifndef NOTIFY_H
+#define NOTIFY_H
+#include <stdatomic.h>
+
+// NOTE - Notificacao entre threads baseada em futex (Linux)
+// O produtor incrementa seq depois de publicar trabalho; o consumidor guarda
+// seq antes de procurar trabalho e, se nao houver, dorme ate seq mudar.
+// Assim nao se perdem notificacoes e quem sinaliza so faz syscall
+// quando existe alguem a dormir (seguro para a callback de audio)
+typedef struct
+{
+	atomic_uint seq;
+	atomic_int waiters;
+} Notifier;
+
+void notifier_init(Notifier *n);
+// Valor atual, a ler ANTES de verificar se ha trabalho
+unsigned notifier_seq(Notifier *n);
+// Acorda quem esteja a espera
+void notifier_signal(Notifier *n);
+// Dorme enquanto seq == seen, no maximo timeout_ms
+// Retorna 1 se houve sinal, 0 se expirou o timeout
+int notifier_wait(Notifier *n, unsigned seen, long timeout_ms);
+
+#endif
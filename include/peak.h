@@ -0,0 +1,35 @@
+#ifndef PEAK_H
+#define PEAK_H
+
+// NOTE - Estimacao do pico entre bins
+// A partir do bin maximo k (amplitudes de um espectro com janela Hann)
+// devolve a posicao fracionaria do pico, em bins.
+//  - PEAK_PARABOLIC: parabola nas amplitudes de k-1, k, k+1 (erro ate ~0.05 bin)
+//  - PEAK_GAUSSIAN:  parabola nos logaritmos (~0.016 bin)
+//  - PEAK_JACOBSEN:  bins complexos, delta = -2 Re[(X+ - X-) / (2X0 - X- - X+)]
+//                    (forma para Hann, ~0.003 bin sem ruido), lidos da FFT
+// peak_zoom refina a estimativa com a DTFT do bloco com janela (equivalente
+// a zero-padding) numa grelha fina a volta do pico.
+
+typedef enum
+{
+	PEAK_BIN = 0,
+	PEAK_PARABOLIC,
+	PEAK_GAUSSIAN,
+	PEAK_JACOBSEN
+} PeakMethod;
+
+// Vertice da parabola por (-1, a), (0, b), (1, c), limitado a [-0.5, 0.5]
+// (0 se os pontos nao formarem um maximo)
+float peak_parabola(double a, double b, double c);
+
+// amp: amplitudes dos bins 0..N/2; re/im: bins complexos da FFT com janela
+// (so para PEAK_JACOBSEN, NULL nos outros)
+float peak_interp(const float *amp, const float *re, const float *im, int N, int k, PeakMethod m);
+
+// Maximo de |DTFT| em [kf - 1, kf + 1] com passo 1/zoom bin, mais uma parabola
+// nessa grelha; custo (2*zoom + 1) * N (zoom ate PEAK_MAX_ZOOM)
+#define PEAK_MAX_ZOOM 32
+float peak_zoom(const float *xw, int N, float kf, int zoom);
+
+#endif
@@ -0,0 +1,36 @@
+#ifndef RAWREC_H
+#define RAWREC_H
+#include "buffer.h"
+#include "rtdb.h"
+
+// NOTE - Gravacao do audio em bruto a volta das falhas do bearing
+// Cada canal guarda referencias (nao copias) aos ultimos RAWREC_PRE_MS de
+// blocos capturados: o dispatcher da uma referencia extra de cada bloco a
+// este anel e o anel liberta a mais antiga quando enche, por isso a pool
+// de captura tem de ter mais slots (rawrec_extra_slots).
+// Quando o valor do bearing na RTDB passa de OK a FAULT, o dispatcher do
+// canal passa as referencias do anel para uma captura e junta-lhe os
+// RAWREC_POST_MS seguintes; a captura completa e escrita num WAV (float) por uma
+// thread de baixa prioridade (ftruncate + mmap) que depois
+// liberta os blocos. O dispatcher so mexe em ponteiros e contadores.
+// Uma captura por canal de cada vez: uma falha que chega com a anterior
+// ainda por escrever e contada e ignorada.
+
+// Slots a juntar a AUDIO_POOL_SLOTS quando a gravacao esta ativa
+int rawrec_extra_slots(void);
+
+// dir: diretorio dos WAV; db: RTDB onde se observam as transicoes
+// Chamada depois de channels_init; arranca a thread de escrita
+int rawrec_start(const char *dir, RTDB *db, int nch);
+// Escreve as capturas pendentes (mesmo incompletas) e liberta os blocos
+// (chamada depois de parar o dispatcher)
+void rawrec_stop(void);
+
+// 1 se a gravacao esta ativa (o dispatcher da uma referencia a mais)
+int rawrec_enabled(void);
+// Dispatcher do canal ch: o bloco b (com a referencia do gravador)
+void rawrec_block(int ch, BufferPool *pool, AudioBuf *b);
+// Blocos do canal retidos pelo gravador (anel + captura)
+int rawrec_held(int ch);
+
+#endif
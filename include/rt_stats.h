@@ -0,0 +1,87 @@
+#ifndef RT_STATS_H
+#define RT_STATS_H
+#include <stdio.h>
+#include <stdint.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include "desc_queue.h"
+
+// NOTE - Instrumentacao temporal das threads
+// Cada thread regista, por ativacao:
+//  - wakeup latency: inicio da ativacao - instante de libertacao
+//    (periodico: next_time; por eventos: publicacao do descritor)
+//  - execution time: fim - inicio da ativacao
+//  - response time: captura do bloco -> publicacao na RTDB
+// e conta deadline misses (fim depois da deadline absoluta).
+// Os histogramas sao lock-free: cada contador e atomico e so a propria
+// thread escreve, qualquer thread pode tirar um snapshot a qualquer momento
+
+// Histograma log-linear: 2^RT_HIST_SUB_BITS bins lineares por potencia de 2
+// (erro relativo < 1/16) de 0 ns ate 2^RT_HIST_MAX_LOG2 ns (~18 min)
+#define RT_HIST_SUB_BITS 4
+#define RT_HIST_SUB (1 << RT_HIST_SUB_BITS)
+#define RT_HIST_MAX_LOG2 40
+#define RT_HIST_BINS ((RT_HIST_MAX_LOG2 - RT_HIST_SUB_BITS + 1) * RT_HIST_SUB)
+
+typedef struct
+{
+	atomic_ulong bins[RT_HIST_BINS];
+	atomic_ulong sum; // ns
+	atomic_ulong max; // ns
+} RtHist;
+
+// Copia de um histograma para calcular percentis sem bloquear o escritor
+typedef struct
+{
+	unsigned long bins[RT_HIST_BINS];
+	unsigned long count;
+	unsigned long sum;
+	unsigned long max;
+} RtHistSnapshot;
+
+void rt_hist_record(RtHist *h, uint64_t ns);
+void rt_hist_snapshot(const RtHist *h, RtHistSnapshot *s);
+// Limite superior do bin que contem o percentil p (0..100); 0 se vazio
+uint64_t rt_hist_percentile(const RtHistSnapshot *s, double p);
+
+// Threads e tarefas instrumentadas (as analises correm como tarefas do runtime)
+typedef enum
+{
+	RT_DISPATCHER = 0,
+	RT_SPEED,
+	RT_BEARING,
+	RT_DISPLAY,
+	RT_NTHREADS
+} RtThreadId;
+
+typedef struct
+{
+	const char *name;
+	long period_ms;		// 0 = sem periodo (dispatcher)
+	int queue;			// fila consumida em cada canal (Channel.q, para as drops), -1 = nenhuma
+
+	atomic_ulong activations;
+	atomic_ulong deadline_misses;
+	RtHist wakeup;
+	RtHist exec;
+	RtHist response;
+} RtStats;
+
+extern RtStats gRtStats[RT_NTHREADS];
+// Pedido de snapshot em runtime (SIGUSR1); o main imprime e limpa (fora das threads RT)
+extern volatile sig_atomic_t rt_stats_dump_request;
+
+void rt_stats_init(RtThreadId id, const char *name, long period_ms, int queue);
+
+// Inicio de uma ativacao libertada em release_ns; retorna o instante de inicio
+uint64_t rt_activation_begin(RtStats *st, uint64_t release_ns);
+// Fim da ativacao iniciada em start_ns com deadline absoluta deadline_ns
+// (deadline_ns == 0: sem deadline)
+void rt_activation_end(RtStats *st, uint64_t start_ns, uint64_t deadline_ns);
+// Resultado publicado na RTDB para um bloco capturado em capture_ns
+void rt_response(RtStats *st, uint64_t capture_ns);
+
+// Imprime p50/p99/p99.9/max de todas as threads e os contadores
+void rt_stats_print(FILE *f);
+
+#endif
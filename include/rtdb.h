@@ -1,25 +1,75 @@
 #ifndef RTDB_H
 #define RTDB_H
-#include <pthread.h>
-
-// NOTE - Real Time Data Base Struct
-typedef struct {
-    pthread_mutex_t mtx;
-    
-    float speed_hz;      
-    int   bearing_fault; 
-    int   direction;     
+#include <stdint.h>
+#include <stdatomic.h>
+#include "config.h"
+
+// NOTE - Real Time Data Base
+// Um slot por canal (indexado pelo id do canal, gChannels) e por campo.
+// Cada campo e protegido por um sequence lock em vez de um mutex:
+//  - so ha um escritor por (campo, canal) de cada vez (a tarefa da analise
+//    do canal, runtime.h): incrementa seq (impar), escreve, incrementa (par)
+//  - os leitores nunca bloqueiam o escritor: copiam e repetem se seq era
+//    impar ou mudou entretanto (o escritor escreve um valor por bloco, as
+//    repeticoes sao raras)
+// Cada valor leva o instante da captura e o n do bloco que o produziu, e
+// cada campo guarda os ultimos RTDB_HISTORY valores num anel.
+// A estrutura nao tem ponteiros (pode ficar em memoria partilhada).
+// Um leitor desiste ao fim de RTDB_READ_RETRIES tentativas (-1, errno
+// EAGAIN): um escritor que morra a meio de uma escrita deixa seq impar.
+
+_Static_assert((RTDB_HISTORY & (RTDB_HISTORY - 1)) == 0, "RTDB_HISTORY must be a power of 2");
+
+typedef enum
+{
+    RTDB_SPEED = 0, // speed_hz
+    RTDB_BEARING,   // fault
+    RTDB_NUM_FIELDS
+} RtdbFieldId;
+
+// NOTE - Um valor publicado
+typedef struct
+{
+    uint64_t t_capture; // instante da captura do bloco (ns, CLOCK_MONOTONIC)
+    uint32_t block;     // n do bloco no canal (AudioDesc.seq)
+    union
+    {
+        float speed_hz;
+        int32_t fault;
+    };
+} RtdbSample;
+
+// NOTE - Campo de um canal: anel de historico com sequence lock
+typedef struct
+{
+    _Alignas(CACHE_LINE) atomic_uint seq; // impar durante uma escrita
+    uint32_t count;                       // valores escritos (o ultimo em count - 1)
+    RtdbSample hist[RTDB_HISTORY];
+} RtdbField;
+
+typedef struct
+{
+    int nch;
+    RtdbField f[MAX_CHANNELS][RTDB_NUM_FIELDS];
 } RTDB;
 
-void rtdb_init(RTDB *db);
+void rtdb_init(RTDB *db, int nch);
 
-// speed manipulation na rtdb
-void rtdb_set_speed(RTDB *db, float hz);
-float rtdb_get_speed(RTDB *db);
+// Publica um valor (um escritor por campo e canal)
+void rtdb_write(RTDB *db, RtdbFieldId f, int ch, const RtdbSample *s);
+// Ultimo valor; retorna 1, 0 se o campo ainda nao foi escrito ou -1 se o
+// campo esteve sempre a ser escrito (errno = EAGAIN); out a zeros se != 1
+int rtdb_read(const RTDB *db, RtdbFieldId f, int ch, RtdbSample *out);
+// Ate n ultimos valores, do mais recente para o mais antigo (n <= RTDB_HISTORY);
+// retorna quantos copiou ou -1 (EAGAIN)
+int rtdb_history(const RTDB *db, RtdbFieldId f, int ch, RtdbSample *out, int n);
 
-// bearing fault manipulation na rtdb
-void rtdb_set_bearing_fault(RTDB *db, int fault);
-int  rtdb_get_bearing_fault(RTDB *db);
+// speed manipulation na rtdb (0 se nao houver valor ou a leitura falhar)
+void rtdb_set_speed(RTDB *db, int ch, float hz, uint64_t t_capture, uint32_t block);
+float rtdb_get_speed(const RTDB *db, int ch);
 
+// bearing fault manipulation na rtdb
+void rtdb_set_bearing_fault(RTDB *db, int ch, int fault, uint64_t t_capture, uint32_t block);
+int rtdb_get_bearing_fault(const RTDB *db, int ch);
 
-#endif
\ No newline at end of file
+#endif
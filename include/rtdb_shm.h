@@ -0,0 +1,91 @@
+#ifndef RTDB_SHM_H
+#define RTDB_SHM_H
+#include <stdint.h>
+#include <stdatomic.h>
+#include <sys/types.h>
+#include "rtdb.h"
+
+/* *******************************************************************
+ * Exportacao da RTDB em memoria partilhada POSIX
+ *
+ * O audio_app cria o segmento (shm_open, por omissao RTDB_SHM_NAME) e
+ * usa a propria RTDB que esta la dentro: nao ha copia nem thread de
+ * exportacao, os escritores sao as tarefas das analises.
+ * Um segmento que ja exista so e substituido se estiver abandonado: o
+ * processo escritor (pid) ja nao existe, state e RTDB_SHM_STOPPED ou o
+ * segmento nem chegou a ter o header. Uma segunda instancia com o mesmo
+ * nome falha (EBUSY) em vez de tomar o segmento da primeira.
+ * Outros processos (HMI, logging) mapeiam o segmento so para leitura e
+ * leem com o mesmo protocolo do seqlock da RTDB (rtdb_read /
+ * rtdb_history em rtdb.h), sem syscalls nem efeito nos escritores.
+ *
+ * Layout (versao 1, little-endian, tudo alinhado ao natural):
+ *   RtdbShmHeader  (offset 0, tamanho header_size)
+ *   RTDB           (offset db_offset)
+ *     int32 nch; RtdbField f[max_channels][num_fields]
+ *     RtdbField (field_size bytes, alinhado a 64):
+ *       uint32 seq; uint32 count; RtdbSample hist[history]
+ *     RtdbSample (sample_size bytes):
+ *       uint64 t_capture (ns, CLOCK_MONOTONIC do sistema)
+ *       uint32 block; float32 speed_hz | int32 fault
+ * Campos: 0 = speed, 1 = bearing (RtdbFieldId).
+ *
+ * Protocolo de leitura de um campo:
+ *   s0 = seq (acquire); se impar repetir
+ *   copiar count e hist[(count - 1 - i) % history]
+ *   fence acquire; se seq != s0 repetir
+ * O cliente deve validar magic, version e os tamanhos antes de usar.
+ * state passa a RTDB_SHM_RUNNING so depois de o segmento estar pronto e
+ * a RTDB_SHM_STOPPED quando o audio_app termina.
+ * *******************************************************************/
+
+#define RTDB_SHM_NAME "/sotr_rtdb"
+#define RTDB_SHM_MAGIC 0x42445452u // "RTDB"
+#define RTDB_SHM_VERSION 1
+
+enum
+{
+    RTDB_SHM_INIT = 0,
+    RTDB_SHM_RUNNING,
+    RTDB_SHM_STOPPED
+};
+
+typedef struct
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t header_size; // sizeof(RtdbShmHeader)
+    uint32_t total_size;  // tamanho do segmento
+    uint32_t db_offset;   // offset da RTDB
+    uint32_t max_channels;
+    uint32_t num_fields;
+    uint32_t history;
+    uint32_t field_size;  // sizeof(RtdbField)
+    uint32_t sample_size; // sizeof(RtdbSample)
+    int32_t pid;          // processo escritor
+    atomic_uint state;    // RTDB_SHM_*
+    uint64_t t_start;     // criacao (ns, CLOCK_MONOTONIC)
+} RtdbShmHeader;
+
+typedef struct
+{
+    RtdbShmHeader hdr;
+    _Alignas(CACHE_LINE) RTDB db;
+} RtdbShm;
+
+// NOTE - Lado do escritor (audio_app)
+// Cria o segmento name (ou substitui um abandonado) com a RTDB iniciada para
+// nch canais; NULL em caso de erro (errno, EBUSY se outro processo vivo o usa)
+RTDB *rtdb_shm_create(const char *name, int nch);
+// pid do escritor vivo do segmento name, 0 se nao existir ou estiver abandonado
+pid_t rtdb_shm_owner(const char *name);
+// Marca o segmento como parado, desmapeia e remove o nome
+void rtdb_shm_destroy(const char *name, RTDB *db);
+
+// NOTE - Biblioteca cliente
+// Mapeia o segmento so para leitura e valida o layout; NULL em caso de erro
+// (errno: ENOENT sem escritor, EPROTO layout incompativel, EAGAIN a iniciar)
+const RtdbShm *rtdb_shm_open(const char *name);
+void rtdb_shm_close(const RtdbShm *shm);
+
+#endif
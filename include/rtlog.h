@@ -0,0 +1,99 @@
+#ifndef RTLOG_H
+#define RTLOG_H
+#include <stdio.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include "config.h"
+
+// NOTE - Log assincrono para os caminhos RT
+// As threads RT nao chamam printf (lock do stdio, write que pode bloquear
+// num terminal ou pipe lento): RTLOG guarda um registo binario num anel
+// lock-free multi-produtor e uma thread de baixa prioridade formata e
+// escreve os registos.
+//  - registo: instante, nivel, formato (string literal) e ate RTLOG_MAX_ARGS
+//    argumentos ja convertidos (inteiros, float/double ou strings estaticas)
+//  - produtor: um CAS para reservar o slot, sem locks nem syscalls (o
+//    instante vem do vDSO); se o anel estiver cheio ou o nivel tiver
+//    excedido o limite por segundo o registo e descartado e contado
+//  - a drenagem e por polling (RTLOG_DRAIN_MS) para os produtores nao
+//    terem de acordar ninguem
+// O formato e interpretado so na drenagem: conversoes d i u x X o c f F e E
+// g G a A s e %% (com flags, largura e precisao fixas; sem '*'). Strings
+// passadas com %s tem de durar ate a drenagem (literais).
+
+typedef enum
+{
+	RTLOG_DEBUG = 0,
+	RTLOG_INFO,
+	RTLOG_WARN,
+	RTLOG_ERROR,
+	RTLOG_LEVELS
+} RtlogLevel;
+
+#define RTLOG_MAX_ARGS 8
+
+typedef union
+{
+	long long i;
+	double d;
+	const char *s;
+} RtlogArg;
+
+typedef struct
+{
+	atomic_ulong seq;   // protocolo do anel (slot livre / publicado)
+	uint64_t t;         // instante (ns, CLOCK_MONOTONIC)
+	const char *fmt;
+	int level;
+	int nargs;
+	RtlogArg args[RTLOG_MAX_ARGS];
+} RtlogRecord;
+
+// Nivel minimo registado (os outros nem entram no anel)
+extern int rtlog_level;
+
+// Arranca a thread de drenagem para o ficheiro out (SCHED_OTHER)
+// rate[nivel]: registos por segundo aceites (0 = sem limite; NULL = RTLOG_RATE_*)
+int rtlog_start(FILE *out, const unsigned *rate);
+// Drena o que falta, para a thread e escreve os contadores de descartes
+void rtlog_stop(void);
+
+void rtlog_write(int level, const char *fmt, int nargs, const RtlogArg *args);
+
+// Conversao de cada argumento pelo tipo (escolhida em compilacao)
+static inline RtlogArg rtlog_arg_i(long long v) { return (RtlogArg){.i = v}; }
+static inline RtlogArg rtlog_arg_d(double v) { return (RtlogArg){.d = v}; }
+static inline RtlogArg rtlog_arg_s(const char *v) { return (RtlogArg){.s = v}; }
+#define RTLOG_ARG(x) _Generic((x),           \
+	float: rtlog_arg_d,                      \
+	double: rtlog_arg_d,                     \
+	char *: rtlog_arg_s,                     \
+	const char *: rtlog_arg_s,               \
+	default: rtlog_arg_i)(x)
+
+#define RTLOG_NARGS_(f, a1, a2, a3, a4, a5, a6, a7, a8, n, ...) n
+#define RTLOG_NARGS(...) RTLOG_NARGS_(__VA_ARGS__, 8, 7, 6, 5, 4, 3, 2, 1, 0, 0)
+#define RTLOG_FMT(f, ...) f
+#define RTLOG_CAT_(a, b) a##b
+#define RTLOG_CAT(a, b) RTLOG_CAT_(a, b)
+#define RTLOG_ARGS0(f) {0}
+#define RTLOG_ARGS1(f, a) RTLOG_ARG(a)
+#define RTLOG_ARGS2(f, a, b) RTLOG_ARG(a), RTLOG_ARG(b)
+#define RTLOG_ARGS3(f, a, b, c) RTLOG_ARGS2(f, a, b), RTLOG_ARG(c)
+#define RTLOG_ARGS4(f, a, b, c, d) RTLOG_ARGS3(f, a, b, c), RTLOG_ARG(d)
+#define RTLOG_ARGS5(f, a, b, c, d, e) RTLOG_ARGS4(f, a, b, c, d), RTLOG_ARG(e)
+#define RTLOG_ARGS6(f, a, b, c, d, e, g) RTLOG_ARGS5(f, a, b, c, d, e), RTLOG_ARG(g)
+#define RTLOG_ARGS7(f, a, b, c, d, e, g, h) RTLOG_ARGS6(f, a, b, c, d, e, g), RTLOG_ARG(h)
+#define RTLOG_ARGS8(f, a, b, c, d, e, g, h, i) RTLOG_ARGS7(f, a, b, c, d, e, g, h), RTLOG_ARG(i)
+
+// RTLOG(nivel, "formato", args...) - ate RTLOG_MAX_ARGS argumentos
+#define RTLOG(level, ...)                                                       \
+	do                                                                          \
+	{                                                                           \
+		if ((level) >= rtlog_level)                                             \
+			rtlog_write((level), RTLOG_FMT(__VA_ARGS__, ), RTLOG_NARGS(__VA_ARGS__), \
+						(const RtlogArg[RTLOG_MAX_ARGS]){                       \
+							RTLOG_CAT(RTLOG_ARGS, RTLOG_NARGS(__VA_ARGS__))(__VA_ARGS__)}); \
+	} while (0)
+
+#endif
@@ -0,0 +1,76 @@
+#ifndef RUNTIME_H
+#define RUNTIME_H
+#include <stdint.h>
+#include "desc_queue.h"
+#include "rt_stats.h"
+
+// NOTE - Runtime de tarefas das analises
+// Um conjunto de workers (um por core, fixados) com deques de work-stealing
+// (wsdeque.h) substitui as threads dedicadas de cada analise:
+//  - cada worker despacha os blocos dos seus canais (dispatcher.h); cada
+//    bloco e publicado na fila de cada analise registada do canal e gera
+//    uma tarefa (analise, canal) no deque do proprio worker
+//  - as tarefas de um par (analise, canal) correm uma de cada vez e por
+//    ordem: a tarefa consome a fila do canal e volta a ser lancada enquanto
+//    houver descritores, por isso o estado por canal das analises (ex.: o
+//    seguidor do speed) nao precisa de locks
+//  - um worker sem trabalho rouba tarefas dos outros, primeiro as de maior
+//    prioridade; sem nada para roubar estaciona (futex) e e acordado quando
+//    outro worker tem tarefas a mais ou chega um bloco de um dos seus canais
+//  - modo periodico: o worker 0 liberta uma tarefa por canal a cada periodo
+//    da analise (sem voltar a lancar), como as antigas threads periodicas
+// A deadline de cada tarefa e a libertacao (publicacao do descritor ou
+// inicio do periodo) mais o periodo da analise.
+
+#define RUNTIME_MAX_ANALYSES 4
+#define RUNTIME_MAX_WORKERS 64
+#define RUNTIME_PRIOS 2 // niveis de prioridade (0 = mais alta)
+
+typedef struct
+{
+	const char *name;
+	RtThreadId stats; // histogramas em gRtStats
+	int prio;		  // 0 .. RUNTIME_PRIOS-1
+	long period_ms;	  // periodo no modo periodico, deadline relativa nos dois
+	int latest_only;  // modo periodico: so o descritor mais recente de cada periodo
+	// Referencias que o descritor leva (as outras analises recebem NULL):
+	// o espectro (d->spec) e o bloco de audio (d->ptr) ficam presos ate a
+	// tarefa acabar, por isso so as analises que os leem os pedem
+	int uses_spectrum;
+	int uses_block;
+	// Chamadas antes de arrancar e depois de parar os workers (podem ser NULL)
+	void (*init)(int nch);
+	void (*fini)(void);
+	// Processa o descritor d (o runtime liberta as referencias depois)
+	void (*process)(const AudioDesc *d);
+	// Descritor ultrapassado em latest_only (pode ser NULL)
+	void (*skip)(const AudioDesc *d);
+} Analysis;
+
+extern volatile int runtime_run;
+
+// Regista uma analise antes de runtime_init; retorna o indice (fila q[i] do
+// canal) ou -1 se ja houver RUNTIME_MAX_ANALYSES
+int runtime_register(const Analysis *a);
+int runtime_analyses(void);
+const Analysis *runtime_analysis(int i);
+
+// nworkers <= 0: um por core disponivel, ate ao n de canais; um valor
+// positivo e usado tal como e (ate RUNTIME_MAX_WORKERS), mesmo acima do n de
+// canais: os workers a mais nao despacham canais e so roubam tarefas
+// cpus/ncpus: cores a usar, por ordem (NULL: os da mascara de afinidade do processo)
+// Chamada pelo main depois de channels_init; distribui os canais (c % nworkers)
+int runtime_init(int nworkers, const int *cpus, int ncpus);
+// Cria e fixa os workers (SCHED_FIFO prio se prio > 0); runtime_join espera
+// que acabem (runtime_run = 0) e chama os fini das analises
+int runtime_start(int prio);
+void runtime_join(void);
+
+// Chamada pelo dispatcher depois de publicar na fila q[a] do canal ch
+// (no worker dono do canal): lanca a tarefa se o par ainda nao estiver ativo
+void runtime_notify(int a, int ch);
+
+// Contadores por worker (tarefas, roubos, vezes que estacionou)
+void runtime_print_stats(FILE *f);
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef SPECTRUM_H
+#define SPECTRUM_H
+#include <stdatomic.h>
+#include <stdint.h>
+#include "config.h"
+#include "fftf.h"
+
+// NOTE - Descritor de espectro
+// O dispatcher calcula o espectro de amplitudes (janela Hann) uma vez por bloco
+// e publica-o junto com o AudioDesc. As threads consumidoras leem os bins
+// e libertam o descritor com spectrum_release (contagem de referencias)
+typedef struct
+{
+	float *amp;		 // amplitudes dos bins 0..N/2 (memoria do slot)
+	float *re, *im;	 // bins complexos 0..N/2 da FFT (interpolacao do pico)
+	float *xw;		 // bloco com janela (N amostras), para o zoom (peak_zoom)
+	int N;			 // tamanho da FFT
+	int nbins;		 // N/2 + 1
+	float fs;		 // frequencia de amostragem (taxa baixa, pode nao ser inteira)
+	atomic_int refs; // n de consumidores que ainda nao libertaram o espectro
+} Spectrum;
+
+// NOTE - Pool de espectros de um canal
+// Um slot esta livre quando refs == 0. So o worker do dispatcher que trata
+// o canal ocupa slots (o plan tem buffers de trabalho: um por pool),
+// as threads consumidoras apenas decrementam refs
+typedef struct
+{
+	Spectrum slot[SPECTRUM_POOL_SIZE];
+	float *mem;		  // amp, re, im e xw de todos os slots
+	FFTFPlan *plan;	  // FFT real em float32 com os kernels SIMD escolhidos no arranque
+	float *window;	  // Hann de N pontos
+	float window_gain; // 1 / soma da janela
+	int N;
+} SpectrumPool;
+
+// Cria o plan da FFT real, a tabela da janela e os slots para blocos de N amostras
+int spectrum_pool_init(SpectrumPool *p, int N);
+void spectrum_pool_destroy(SpectrumPool *p);
+
+// Calcula o espectro do bloco (ja filtrado, em float, p->N amostras) num
+// slot livre da pool, com nrefs referencias
+// Retorna NULL se nao houver slots livres (so chamada pelo dono da pool)
+Spectrum *spectrum_compute(SpectrumPool *p, const float *x, float fs, int nrefs);
+
+// Liberta uma referencia (aceita NULL)
+void spectrum_release(Spectrum *s);
+
+// Frequencia central do bin k
+static inline float spectrum_bin_freq(const Spectrum *s, int k)
+{
+	return (float)k * s->fs / (float)s->N;
+}
+
+#endif
@@ -1,17 +1,14 @@
 #ifndef SPEED_H
 #define SPEED_H
-#include <pthread.h>
-#include "desc_queue.h"
+#include <stdio.h>
 #include "rtdb.h"
 
-// NOTE - Thread de medição de Speed
-extern pthread_t speed_th;
-// Var de controlo do estado da thread
-extern volatile int speed_run;
+// NOTE - Analise de Speed
+// Corre como tarefa do runtime (runtime.h), um canal de cada vez.
+// Regista a analise e da-lhe a rtdb; retorna o indice da fila no canal
+int speed_register(RTDB *db);
+// Contadores do seguidor (speed_track.h) somados em todos os canais,
+// depois de o runtime parar; nada se o seguimento estiver desligado
+void speed_print_stats(FILE *f);
 
-// NOTE - Funcao da thread de speed
-void *speed_loop(void *arg);
-// Da ao modulo speed a rtdb
-void speed_set_rtdb(RTDB *db);
-
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,34 @@
+#ifndef SPEED_TRACK_H
+#define SPEED_TRACK_H
+#include "spectrum.h"
+
+// NOTE - Seguimento do speed a volta da ultima estimativa
+// Com lock, o pico so e procurado nos bins da FFT (ja calculada pelo
+// dispatcher) da banda de SPEED_TRACK_SPAN_HZ a volta da ultima estimativa
+// (rtdb_get_speed) e interpolado com SPEED_PEAK_METHOD sobre os mesmos bins,
+// como na procura completa. Nao ha avaliacao da banda numa grelha mais fina
+// (a resolucao e a da interpolacao, mais o zoom so se SPEED_ZOOM > 0): o
+// ganho e que outros picos fora da banda nao roubam a estimativa.
+// Perde o lock se o pico cair na borda da banda (o motor saiu da banda) ou
+// se a amplitude baixar de SPEED_TRACK_LOCK_RATIO vezes a media das ultimas;
+// nesse caso, e a cada SPEED_TRACK_REACQUIRE ciclos, volta a procura em todo
+// o espectro (compute_dominant_freq) e retoma o lock a volta do novo pico.
+
+typedef struct
+{
+	int N;			   // tamanho do bloco (= Spectrum.N)
+	float fs;		   // taxa do bloco
+	float span_hz;	   // largura da banda seguida
+	int locked;
+	int since_full;	   // ciclos desde a ultima procura completa
+	float ref_amp;	   // media exponencial da amplitude do pico com lock
+	unsigned long tracked, full, lost; // contadores (diagnostico)
+} SpeedTracker;
+
+// Blocos de N amostras a taxa fs; retorna -1 se a banda for invalida
+// (a banda nunca fica com menos de dois bins de cada lado do pico)
+int speed_track_init(SpeedTracker *t, int N, float fs, float span_hz);
+// Estimativa em Hz para o espectro s; last_hz <= 0 obriga a procura completa
+float speed_track_update(SpeedTracker *t, const Spectrum *s, float last_hz);
+
+#endif
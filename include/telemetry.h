@@ -0,0 +1,125 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+#include <stdint.h>
+
+/* *******************************************************************
+ * Registo de telemetria por bloco
+ *
+ * Cada bloco analisado pelo speed gera um TelemetryRecord (um por canal
+ * e bloco). O produtor so copia o registo para um anel SPSC do canal
+ * (sem locks nem syscalls; descartado e contado se estiver cheio); uma
+ * thread de baixa prioridade junta os registos de todos os canais em
+ * chunks colunares e escreve-os com O_DIRECT (escritas alinhadas a
+ * TELEM_ALIGN, sem passar pela page cache).
+ * No modo periodico o speed so analisa um bloco por periodo: os outros
+ * blocos (descartados da fila) nao aparecem na telemetria.
+ *
+ * Formato do ficheiro (versao 1, little-endian), blocos de TELEM_ALIGN:
+ *   TelemFileHeader   descricao das colunas (nome, tipo, tamanho)
+ *   TelemChunk ...    TelemChunkHeader e depois as colunas, uma a seguir
+ *                     a outra (nrec valores cada, alinhadas a 8 bytes,
+ *                     offsets em col_off); ocupa `bytes` (multiplo de
+ *                     TELEM_ALIGN)
+ *   TelemIndex        a cada TELEM_INDEX_CHUNKS chunks e no fim: entradas
+ *                     dos chunks desde o indice anterior e o offset desse
+ *                     indice (lista ligada do fim para o inicio)
+ * Um ficheiro fechado normalmente acaba num TelemIndex; depois de uma
+ * falha o leitor percorre os chunks desde o inicio (cada bloco comeca
+ * por um magic).
+ * *******************************************************************/
+
+#define TELEM_ALIGN 4096
+#define TELEM_MAGIC_FILE 0x314d4c54u  // "TLM1"
+#define TELEM_MAGIC_CHUNK 0x434d4c54u // "TLMC"
+#define TELEM_MAGIC_INDEX 0x494d4c54u // "TLMI"
+#define TELEM_VERSION 1
+#define TELEM_MAX_COLS 16
+
+// NOTE - Registo de um bloco (forma dos produtores)
+typedef struct
+{
+	uint64_t t_capture;	 // instante da captura (ns, CLOCK_MONOTONIC)
+	uint32_t block;		 // n do bloco no canal
+	uint16_t ch;
+	uint8_t fault;		 // decisao do bearing
+	float speed_hz;
+	float lf_peak;		 // amplitudes dos bancos de Goertzel do bearing
+	float motor_peak;
+	// Latencias por estagio (ns, saturadas em UINT32_MAX = 4.29 s: telem_ns32)
+	uint32_t wait_ns;	  // captura -> inicio do dispatch
+	uint32_t dispatch_ns; // filtro, decimacao, Goertzel e espectro
+	uint32_t queue_ns;	  // publicacao -> inicio da tarefa do speed
+	uint32_t speed_ns;	  // execucao do speed
+} TelemetryRecord;
+
+// Intervalo (ns) para as colunas de 32 bits; intervalos acima de 4.29 s (ou
+// negativos, com t_capture de outro relogio) ficam em UINT32_MAX
+static inline uint32_t telem_ns32(uint64_t t0, uint64_t t1)
+{
+	return t1 < t0 || t1 - t0 > UINT32_MAX ? UINT32_MAX : (uint32_t)(t1 - t0);
+}
+
+typedef enum
+{
+	TELEM_U8 = 1,
+	TELEM_U16,
+	TELEM_U32,
+	TELEM_U64,
+	TELEM_F32
+} TelemType;
+
+typedef struct
+{
+	char name[16];
+	uint32_t type; // TelemType
+	uint32_t size; // bytes por valor
+} TelemColumn;
+
+typedef struct
+{
+	uint32_t magic; // TELEM_MAGIC_FILE
+	uint32_t version;
+	uint32_t ncols;
+	uint32_t nch;
+	uint64_t t_start_mono; // CLOCK_MONOTONIC na abertura (ns)
+	int64_t t_start_real;  // CLOCK_REALTIME no mesmo instante (ns desde 1970)
+	TelemColumn col[TELEM_MAX_COLS];
+} TelemFileHeader;
+
+typedef struct
+{
+	uint32_t magic; // TELEM_MAGIC_CHUNK
+	uint32_t nrec;
+	uint32_t bytes;	  // tamanho do chunk no ficheiro
+	uint32_t ch_mask; // canais presentes (bit c)
+	uint64_t seq;	  // n do chunk
+	uint64_t t_first, t_last; // t_capture minimo e maximo
+	uint32_t col_off[TELEM_MAX_COLS]; // offset de cada coluna no chunk
+} TelemChunkHeader;
+
+typedef struct
+{
+	uint64_t off; // offset do chunk no ficheiro
+	uint32_t nrec;
+	uint32_t ch_mask;
+	uint64_t t_first, t_last;
+} TelemIndexEntry;
+
+#define TELEM_INDEX_CHUNKS 64
+typedef struct
+{
+	uint32_t magic; // TELEM_MAGIC_INDEX
+	uint32_t n;		// entradas
+	uint64_t prev;	// offset do indice anterior (0 = nenhum)
+	uint64_t total; // registos no ficheiro ate aqui
+	TelemIndexEntry e[TELEM_INDEX_CHUNKS];
+} TelemIndex;
+
+// Abre o ficheiro e arranca a thread de escrita (SCHED_OTHER); -1 se falhar
+int telemetry_start(const char *path, int nch);
+// Escreve o que falta, o indice final e fecha
+void telemetry_stop(void);
+// Produtor: um por canal de cada vez (a tarefa do speed do canal)
+void telemetry_record(const TelemetryRecord *r);
+
+#endif
@@ -1,6 +1,7 @@
 #ifndef TIME_UTILS_H
 #define TIME_UTILS_H
 #include <time.h>
+#include <stdint.h>
 
 // NOTE - Função auxiliar para adicionar ms a um timespec 
 static inline void add_ms(struct timespec *t, long ms)
@@ -10,4 +11,26 @@ static inline void add_ms(struct timespec *t, long ms)
     t->tv_nsec %= 1000000000L;
 }
 
+// NOTE - Função auxiliar para adicionar ns a um timespec (ns < 1 s)
+static inline void add_ns(struct timespec *t, long ns)
+{
+    t->tv_nsec += ns;
+    t->tv_sec += t->tv_nsec / 1000000000L;
+    t->tv_nsec %= 1000000000L;
+}
+
+// NOTE - Conversao de timespec para ns (para as medicoes de tempos)
+static inline uint64_t ts_to_ns(const struct timespec *t)
+{
+    return (uint64_t)t->tv_sec * 1000000000ull + (uint64_t)t->tv_nsec;
+}
+
+// Instante atual em ns (CLOCK_MONOTONIC, o mesmo dos clock_nanosleep)
+static inline uint64_t now_ns(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return ts_to_ns(&t);
+}
+
 #endif
\ No newline at end of file
@@ -0,0 +1,32 @@
+#ifndef WSDEQUE_H
+#define WSDEQUE_H
+#include <stdatomic.h>
+#include "config.h"
+
+// NOTE - Deque de work-stealing (Chase-Lev, versao C11 de Le et al. 2013)
+// O dono faz push e pop no fundo (LIFO: a tarefa mais recente, com os dados
+// ainda na cache); os outros workers roubam do topo (FIFO) com um CAS.
+// So o pop do ultimo elemento disputa o topo com os ladroes.
+// Os elementos sao palavras (long) atomicas: sem alocacao e sem copias
+// parciais a correr em paralelo com o dono. Capacidade fixa (potencia de 2).
+typedef struct
+{
+	_Alignas(CACHE_LINE) atomic_long top; // proximo a roubar
+	_Alignas(CACHE_LINE) atomic_long bottom; // proximo slot livre (so o dono escreve)
+	atomic_long *buf;
+	long mask;
+} WsDeque;
+
+// capacity e arredondada para a potencia de 2 seguinte; retorna -1 se falhar
+int wsdeque_init(WsDeque *q, int capacity);
+void wsdeque_destroy(WsDeque *q);
+// Dono: retorna 0 se estiver cheio
+int wsdeque_push(WsDeque *q, long v);
+// Dono: retorna 0 se estiver vazio
+int wsdeque_pop(WsDeque *q, long *v);
+// Qualquer thread: retorna 0 se estiver vazio ou se perdeu a corrida
+int wsdeque_steal(WsDeque *q, long *v);
+// Aproximado (para decidir se vale a pena acordar outro worker)
+long wsdeque_size(WsDeque *q);
+
+#endif
@@ -1,14 +1,13 @@
 #include <string.h>
 #include "audio_io.h"
+#include "audio_source.h"
+#include "rawrec.h"
 
-SDL_AudioDeviceID gRecDev = 0;
-
-AudioBuf bufA, bufB;
-AudioBuf *curBuf = &bufA;
+SDL_AudioDeviceID gRecDev[MAX_CHANNELS];
 
 void audio_recording_callback(void *userdata, Uint8 *stream, int len)
 {
-    (void)userdata;
+    AudioSource *src = userdata;
     
     // NOTE - Recolha de amostras para o buffer antigo
 	// Foi retirada pois agora recolhemos as amostras para o double buffer
@@ -19,35 +18,62 @@ void audio_recording_callback(void *userdata, Uint8 *stream, int len)
 	/* Update buffer pointer */
 	// gBufferBytePosition += len;
 
-	// NOTE - Recolher os dados para os buffers A e B e ir alternando
-	// Através do curBuf
+	// As tramas vem no formato obtido do dispositivo (src->fmt)
+	audio_capture_push_frames(src->first_channel, &src->fmt, stream, len / src->fmt.frame_bytes);
+}
 
-	// Determinação do número exato de bytes a copiar
-	int expected_bytes = sizeof(curBuf->data);
-	int tocopy = (len < expected_bytes) ? len : expected_bytes;
+unsigned audio_capture_next_seq(int ch)
+{
+	return gChannels[ch].pool.next_seq;
+}
 
-	// Copia dos dados para o current Buffer
-	if (!curBuf->full && !curBuf->ready_to_consume)
-	{
-		// cast para o memcpy interpretar o inicio do array data como ponteiro para bytes
-		// Pois ele espera um ponteiro para bytes
-		memcpy((Uint8 *)curBuf->data, stream, tocopy);
-		// REVIEW - estamos a considerar full quando len < expected_bytes
-		// Não é correto, devemos alterar mais à frente
-		curBuf->full = 1;
-		// Efetuar a troca de buffer
-		curBuf = (curBuf == &bufA) ? &bufB : &bufA;
-	}
+// NOTE - Recolher as amostras para os blocos da pool do canal
+// Blocos parciais continuam na chamada seguinte; se todos os blocos
+// estiverem em uso as amostras perdem-se (conta nas stats). Cada bloco
+// completo acorda o worker do canal (sem syscall se ele nao estiver a dormir)
+// A conversao para float e a remocao do DC sao feitas na mesma passagem,
+// diretamente para o bloco; o DC do pedaco seguinte sai das somas desta
+static int capture_write(Channel *c, const IngestFormat *fmt, const void *frames, int k, int n)
+{
+	IngestSrc src;
+	ingest_src_init(&src, fmt, frames, k, c->dc.dc);
+	int published = buffer_pool_write(&c->pool, &src, n);
+	ingest_dc_update(&c->dc, &src, SAMP_FREQ);
+	if (published && c->wake)
+		notifier_signal(c->wake);
+	return published;
+}
 
-	/*NOTE - Ate agora no que implementamos, ainda não temos codigo
-	para esvaziar os buffers. Portanto teoricamente ele vai aceder
-	ao 1º buffer, echer, depois ao 2º, encher, e depois vai dropar todos
-	os blocos a partir de ai pois nao temos maneira de os esvaziar implementada ainda*/
+int audio_capture_push(int ch, const IngestFormat *fmt, const void *samples, int len)
+{
+	return capture_write(&gChannels[ch], fmt, samples, 0, len);
+}
+
+int audio_capture_push_frames(int first_ch, const IngestFormat *fmt, const void *frames, int nframes)
+{
+	// Desintercalar diretamente para o bloco de cada canal
+	int pushed = 0;
+	for (int k = 0; k < fmt->channels; k++)
+		pushed += capture_write(&gChannels[first_ch + k], fmt, frames, k, nframes);
+	return pushed;
+}
 
+int audio_capture_wait_space(int ch, int max_inflight, long timeout_ms)
+{
+	BufferPool *p = &gChannels[ch].pool;
+	for (;;)
+	{
+		unsigned seen = notifier_seq(&p->freed);
+		// Os blocos retidos pelo gravador das falhas nao estao a espera das analises
+		int inflight = p->nslots - atomic_load_explicit(&p->nfree, memory_order_relaxed) - rawrec_held(ch);
+		if (inflight < max_inflight)
+			return 1;
+		if (!notifier_wait(&p->freed, seen, timeout_ms))
+			return 0;
+	}
 }
 
-void audio_release_buffer(int16_t *ptr) {
-    SDL_LockAudioDevice(gRecDev);
-    buffer_release_nolock(ptr, &bufA, &bufB);
-    SDL_UnlockAudioDevice(gRecDev);
-}
\ No newline at end of file
+void audio_release_buffer(int ch, float *ptr) {
+    // Contagem de referencias atomica, nao precisa do lock do device
+    buffer_pool_release(&gChannels[ch].pool, ptr);
+}
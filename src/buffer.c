@@ -1,27 +1,218 @@
+#include <stdlib.h>
+#include <string.h>
 #include "buffer.h"
+#include "time_utils.h"
+#include "cpu_utils.h"
 
-// NOTE - Inicializa todos os campos do buffer a zero
-void buffer_init(AudioBuf *b)
+// NOTE - Inicializa a pool: todos os blocos livres e a zero
+int buffer_pool_init(BufferPool *p, int nslots, int block_samples)
 {
-    b->full = 0;
-    b->ready_to_consume = 0;
-    for (int i = 0; i < ABUFSIZE_SAMPLES; i++)
-        b->data[i] = 0;
+    memset(p, 0, sizeof(*p));
+
+    // Cada bloco comeca numa cache line
+    const int per_line = CACHE_LINE / sizeof(float);
+    p->stride = (block_samples + per_line - 1) / per_line * per_line;
+    p->nslots = nslots;
+    p->block_samples = block_samples;
+    unsigned cap = 1;
+    while (cap < (unsigned)nslots)
+        cap <<= 1;
+    p->ring_mask = cap - 1;
+
+    p->slots = calloc(nslots, sizeof(AudioBuf));
+    p->mem = aligned_alloc(CACHE_LINE, sizeof(float) * p->stride * nslots);
+    p->free_ring = calloc(cap, sizeof(*p->free_ring));
+    p->full_ring = calloc(cap, sizeof(*p->full_ring));
+    if (!p->slots || !p->mem || !p->free_ring || !p->full_ring)
+    {
+        buffer_pool_destroy(p);
+        return -1;
+    }
+    memset(p->mem, 0, sizeof(float) * p->stride * nslots);
+
+    for (int i = 0; i < nslots; i++)
+    {
+        AudioBuf *b = &p->slots[i];
+        b->data = p->mem + (size_t)i * p->stride;
+        b->len = 0;
+        atomic_init(&b->state, BUF_FREE);
+        atomic_init(&b->refs, 0);
+    }
+    // Todos os slots no anel dos livres (posicoes 0..nslots-1)
+    for (unsigned i = 0; i < cap; i++)
+    {
+        atomic_init(&p->free_ring[i].seq, i < (unsigned)nslots ? i + 1 : i);
+        p->free_ring[i].slot = (int)i;
+    }
+    atomic_init(&p->free_head, nslots);
+    p->free_tail = 0;
+    atomic_init(&p->full_head, 0);
+    atomic_init(&p->full_tail, 0);
+    p->filling = NULL;
+    p->fill = 0;
+    p->dropping = 0;
+
+    atomic_init(&p->nfree, nslots);
+    atomic_init(&p->free_lowwater, nslots);
+    atomic_init(&p->captured, 0);
+    atomic_init(&p->capture_drops, 0);
+    notifier_init(&p->freed);
+    return 0;
 }
 
-// NOTE - Funcao para as threads consumidoras libertarem o buffer 
-void buffer_release_nolock(int16_t *ptr, AudioBuf *a, AudioBuf *b)
+void buffer_pool_destroy(BufferPool *p)
 {
+    free(p->slots);
+    free(p->mem);
+    free(p->free_ring);
+    free(p->full_ring);
+    p->slots = NULL;
+    p->mem = NULL;
+    p->free_ring = NULL;
+    p->full_ring = NULL;
+}
+
+// NOTE - Captura reserva um slot livre (consumidor unico do anel dos livres)
+AudioBuf *buffer_pool_acquire(BufferPool *p)
+{
+    const unsigned pos = p->free_tail;
+    BufFreeCell *cell = &p->free_ring[pos & p->ring_mask];
+    // Vazio, ou quem liberta reservou a posicao e ainda nao escreveu o slot
+    if (atomic_load_explicit(&cell->seq, memory_order_acquire) != pos + 1)
+    {
+        // Todos os slots ocupados: o bloco capturado perde-se
+        atomic_fetch_add_explicit(&p->capture_drops, 1, memory_order_relaxed);
+        return NULL;
+    }
+    AudioBuf *b = &p->slots[cell->slot];
+    // Celula livre para a volta seguinte do anel
+    atomic_store_explicit(&cell->seq, pos + p->ring_mask + 1, memory_order_release);
+    p->free_tail = pos + 1;
+
+    atomic_store_explicit(&b->state, BUF_FILLING, memory_order_relaxed);
+    int nfree = atomic_fetch_sub_explicit(&p->nfree, 1, memory_order_relaxed) - 1;
+    // so a captura reserva slots, nao ha escritas concorrentes do minimo
+    if (nfree < atomic_load_explicit(&p->free_lowwater, memory_order_relaxed))
+        atomic_store_explicit(&p->free_lowwater, nfree, memory_order_relaxed);
+    return b;
+}
+
+void buffer_pool_publish(BufferPool *p, AudioBuf *b, int len)
+{
+    b->len = len;
+    b->seq = p->next_seq++;
+    b->t_capture = now_ns();
+    atomic_fetch_add_explicit(&p->captured, 1, memory_order_relaxed);
+    atomic_store_explicit(&b->state, BUF_FULL, memory_order_relaxed);
+
+    // release: os dados e o cabecalho do bloco ficam visiveis antes do indice
+    unsigned head = atomic_load_explicit(&p->full_head, memory_order_relaxed);
+    p->full_ring[head & p->ring_mask] = (int)(b - p->slots);
+    atomic_store_explicit(&p->full_head, head + 1, memory_order_release);
+}
 
-    if (ptr == a->data)
+// NOTE - Captura por partes
+// As callbacks nao entregam necessariamente blocos inteiros: o bloco em
+// preenchimento passa de uma chamada para a outra e so fica cheio quando
+// tem block_samples amostras. Sem slot livre, as amostras de um bloco
+// inteiro perdem-se (um drop, mesmo que venham em varias chamadas) e a
+// captura segue no bloco seguinte, com as fronteiras dos blocos no sitio.
+int buffer_pool_write(BufferPool *p, IngestSrc *src, int n)
+{
+    int published = 0;
+    while (n > 0)
     {
-        a->full = 0;
-        a->ready_to_consume = 0;
+        if (!p->filling && !p->dropping)
+        {
+            p->filling = buffer_pool_acquire(p);
+            p->fill = 0;
+            p->dropping = p->filling == NULL;
+        }
+
+        int k = p->block_samples - p->fill;
+        if (k > n)
+            k = n;
+        if (p->dropping)
+            ingest_skip(src, k);
+        else
+            ingest_read(src, p->filling->data + p->fill, k);
+        n -= k;
+        p->fill += k;
+
+        if (p->fill == p->block_samples)
+        {
+            if (!p->dropping)
+            {
+                buffer_pool_publish(p, p->filling, p->fill);
+                published++;
+            }
+            p->filling = NULL;
+            p->dropping = 0;
+        }
     }
-    else if (ptr == b->data)
+    return published;
+}
+
+// NOTE - Dispatcher retira o bloco cheio mais antigo (pela ordem de captura)
+AudioBuf *buffer_pool_next_full(BufferPool *p)
+{
+    unsigned tail = atomic_load_explicit(&p->full_tail, memory_order_relaxed);
+    if (tail == atomic_load_explicit(&p->full_head, memory_order_acquire))
+        return NULL;
+    AudioBuf *b = &p->slots[p->full_ring[tail & p->ring_mask]];
+    atomic_store_explicit(&p->full_tail, tail + 1, memory_order_release);
+    return b;
+}
+
+// NOTE - Devolve o bloco ao anel dos livres (qualquer thread)
+static void make_free(BufferPool *p, AudioBuf *b)
+{
+    atomic_store_explicit(&b->state, BUF_FREE, memory_order_relaxed);
+    unsigned pos = atomic_fetch_add_explicit(&p->free_head, 1, memory_order_relaxed);
+    BufFreeCell *cell = &p->free_ring[pos & p->ring_mask];
+    // A celula ja foi libertada pela captura: o anel nunca tem mais do que
+    // nslots blocos, por isso esta espera quase nunca roda (so se a captura
+    // for interrompida entre ler o slot e libertar a celula)
+    while (atomic_load_explicit(&cell->seq, memory_order_acquire) != pos)
+        cpu_relax();
+    cell->slot = (int)(b - p->slots);
+    atomic_store_explicit(&cell->seq, pos + 1, memory_order_release);
+    atomic_fetch_add_explicit(&p->nfree, 1, memory_order_relaxed);
+    notifier_signal(&p->freed);
+}
+
+void buffer_pool_dispatch(BufferPool *p, AudioBuf *b, int nrefs)
+{
+    if (nrefs <= 0)
     {
-        b->full = 0;
-        b->ready_to_consume = 0;
+        make_free(p, b);
+        return;
     }
+    // refs fica definido antes de qualquer consumidor ver o bloco
+    atomic_store_explicit(&b->refs, nrefs, memory_order_relaxed);
+    atomic_store_explicit(&b->state, BUF_DISPATCHED, memory_order_release);
+}
+
+// NOTE - Funcao para as threads consumidoras libertarem o buffer
+// O bloco so e reciclado quando o ultimo consumidor o liberta
+void buffer_pool_release(BufferPool *p, const float *ptr)
+{
+    if (!ptr || ptr < p->mem)
+        return;
+    size_t i = (size_t)(ptr - p->mem) / p->stride;
+    if (i >= (size_t)p->nslots)
+        return;
+
+    AudioBuf *b = &p->slots[i];
+    if (atomic_fetch_sub_explicit(&b->refs, 1, memory_order_acq_rel) == 1)
+        make_free(p, b);
+}
 
-}
\ No newline at end of file
+void buffer_pool_stats(BufferPool *p, BufferPoolStats *st)
+{
+    st->nslots = p->nslots;
+    st->nfree = atomic_load_explicit(&p->nfree, memory_order_relaxed);
+    st->free_lowwater = atomic_load_explicit(&p->free_lowwater, memory_order_relaxed);
+    st->captured = atomic_load_explicit(&p->captured, memory_order_relaxed);
+    st->capture_drops = atomic_load_explicit(&p->capture_drops, memory_order_relaxed);
+}
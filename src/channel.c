@@ -0,0 +1,79 @@
+#include <stdlib.h>
+#include <string.h>
+#include "channel.h"
+
+Channel *gChannels = NULL;
+int gNumChannels = 0;
+
+static int channel_init(Channel *c, int id, int pool_slots)
+{
+	c->id = id;
+	atomic_init(&c->blocks, 0);
+	if (buffer_pool_init(&c->pool, pool_slots, ABUFSIZE_SAMPLES) != 0)
+		return -1;
+	for (int a = 0; a < RUNTIME_MAX_ANALYSES; a++)
+	{
+		atomic_init(&c->active[a], 0);
+		if (desc_queue_init(&c->q[a], DESCRIPTOR_QUEUE_CAPACITY) != 0)
+			return -1;
+	}
+
+	c->filtered = aligned_alloc(32, sizeof(float) * ABUFSIZE_SAMPLES);
+	c->lowrate = aligned_alloc(32, sizeof(float) * (ABUFSIZE_SAMPLES / DECIM_FACTOR + 8));
+	c->analysis = aligned_alloc(32, sizeof(float) * ((ANALYSIS_N + 7) & ~7));
+	if (!c->filtered || !c->lowrate || !c->analysis)
+		return -1;
+	memset(c->analysis, 0, sizeof(float) * ANALYSIS_N);
+
+	if (iir_design_butter_lp(&c->lpf, LPF_ORDER, CUTOFF_HZ, SAMP_FREQ) != 0 ||
+		iir_set_block(&c->lpf, ABUFSIZE_SAMPLES) != 0 ||
+		decim_init(&c->decim, DECIM_FACTOR, DECIM_TAPS_PER_PHASE, DECIM_CUTOFF, ABUFSIZE_SAMPLES) != 0 ||
+		bearing_bank_init(&c->bbank, BEARING_N, ANALYSIS_FS, ABUFSIZE_SAMPLES / DECIM_FACTOR + 1,
+						  BEARING_MOTOR_MIN, BEARING_MOTOR_MAX, BEARING_LOWF_TH, BEARING_REL_TH) != 0)
+		return -1;
+	return spectrum_pool_init(&c->spec, ANALYSIS_N);
+}
+
+static void channel_destroy(Channel *c)
+{
+	buffer_pool_destroy(&c->pool);
+	for (int a = 0; a < RUNTIME_MAX_ANALYSES; a++)
+		desc_queue_destroy(&c->q[a]);
+	iir_destroy(&c->lpf);
+	decim_destroy(&c->decim);
+	bearing_bank_destroy(&c->bbank);
+	spectrum_pool_destroy(&c->spec);
+	free(c->filtered);
+	free(c->lowrate);
+	free(c->analysis);
+}
+
+int channels_init(int n, int pool_slots)
+{
+	if (n < 1 || n > MAX_CHANNELS)
+		return -1;
+
+	// Alinhado a cache line: os indices das filas e os contadores de canais
+	// vizinhos nao partilham linhas
+	gChannels = aligned_alloc(CACHE_LINE, sizeof(Channel) * n);
+	if (!gChannels)
+		return -1;
+	memset(gChannels, 0, sizeof(Channel) * n);
+	gNumChannels = n;
+	for (int i = 0; i < n; i++)
+		if (channel_init(&gChannels[i], i, pool_slots) != 0)
+		{
+			channels_destroy();
+			return -1;
+		}
+	return 0;
+}
+
+void channels_destroy(void)
+{
+	for (int i = 0; i < gNumChannels; i++)
+		channel_destroy(&gChannels[i]);
+	free(gChannels);
+	gChannels = NULL;
+	gNumChannels = 0;
+}
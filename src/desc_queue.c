@@ -1,58 +1,159 @@
+#include <stdlib.h>
 #include <string.h>
 #include "desc_queue.h"
+#include "cpu_utils.h"
 
 
 // Funcao de inicialização das filas de descritores do dispatcher
-// Colocar tudo a zero e inicializar mtx
-void desc_queue_init(DescQueue *q)
+// Colocar tudo a zero e alocar os slots (capacidade potencia de 2)
+int desc_queue_init(DescQueue *q, int capacity)
 {
-    memset(q, 0, sizeof(*q));
-    pthread_mutex_init(&q->mtx, NULL);
+	unsigned cap = 1;
+	while (cap < (unsigned)capacity)
+		cap <<= 1;
+
+	memset(q, 0, sizeof(*q));
+	q->desc = calloc(cap, sizeof(DescCell));
+	if (!q->desc)
+		return -1;
+	for (unsigned i = 0; i < cap; i++)
+		atomic_init(&q->desc[i].seq, i);
+
+	q->capacity = cap;
+	q->mask = cap - 1;
+	atomic_init(&q->head, 0);
+	atomic_init(&q->tail, 0);
+	atomic_init(&q->dropped, 0);
+	atomic_init(&q->subscribed, 0);
+	notifier_init(&q->ready);
+	q->wake = &q->ready;
+	return 0;
+}
+
+void desc_queue_destroy(DescQueue *q)
+{
+	free(q->desc);
+	q->desc = NULL;
 }
 
 // Funcao de push das filas do dispatcher
 // Recebe ponteiro para a queue a adicionar o descritor
 // E também o descritor a adicionar
-int desc_queue_push(DescQueue *q, AudioDesc d)
+int desc_queue_push(DescQueue *q, AudioDesc d, AudioDesc *dropped)
 {
+	int ok = 1;
 
-	pthread_mutex_lock(&q->mtx);
+	// head so e escrito por nos
+	unsigned h = atomic_load_explicit(&q->head, memory_order_relaxed);
+	unsigned t = atomic_load_explicit(&q->tail, memory_order_acquire);
 
 	// Ver se a fila ja esta cheia
-	// Se sim descartamos o mais antigo
-	if (q->count == DESCRIPTOR_QUEUE_CAPACITY)
+	// Se sim descartamos o mais antigo, disputando o tail com o consumidor
+	while (h - t >= q->capacity)
 	{
-		q->tail = (q->tail + 1) % DESCRIPTOR_QUEUE_CAPACITY;
-		q->count--;
+		if (atomic_compare_exchange_weak_explicit(&q->tail, &t, t + 1,
+												  memory_order_acq_rel,
+												  memory_order_acquire))
+		{
+			// A posicao t e nossa: copiar e devolver o slot
+			DescCell *old = &q->desc[t & q->mask];
+			if (dropped)
+				*dropped = old->d;
+			atomic_store_explicit(&old->seq, t + q->capacity, memory_order_release);
+			atomic_fetch_add_explicit(&q->dropped, 1, memory_order_relaxed);
+			ok = 0;
+			break;
+		}
+		// CAS falhou: t foi atualizado (o consumidor fez pop), voltar a verificar
 	}
 
-	q->desc[q->head] = d;
-	q->head = (q->head + 1) % DESCRIPTOR_QUEUE_CAPACITY;
-	q->count++;
-
-	pthread_mutex_unlock(&q->mtx);
+	// Esperar que quem tirou a posicao h - capacity acabe de copiar o slot
+	// (no maximo a copia de um descritor)
+	DescCell *cell = &q->desc[h & q->mask];
+	while (atomic_load_explicit(&cell->seq, memory_order_acquire) != h)
+		cpu_relax();
+	cell->d = d;
+	atomic_store_explicit(&cell->seq, h + 1, memory_order_release);
+	// O slot so fica visivel ao consumidor depois de publicar o head
+	atomic_store_explicit(&q->head, h + 1, memory_order_release);
+	// wake so e lido depois de ver a subscricao (acquire): antes dela, o da fila
+	notifier_signal(atomic_load_explicit(&q->subscribed, memory_order_acquire) ? q->wake : &q->ready);
 
-	return 1;
+	return ok;
 }
 
 // Funcao para fazer pop nas filas static de descritores
 // Parametro out para a thread depois ter acesso aos dados do descritor
 int desc_queue_pop(DescQueue *q, AudioDesc *out)
 {
+	unsigned t = atomic_load_explicit(&q->tail, memory_order_acquire);
+
+	for (;;)
+	{
+		unsigned h = atomic_load_explicit(&q->head, memory_order_acquire);
+
+		// Se não tiver descritores a processar
+		if (t == h)
+			return 0;
+
+		// Reservar a posicao antes de copiar: o produtor so volta a escrever
+		// no slot depois de seq passar a t + capacity
+		if (atomic_compare_exchange_weak_explicit(&q->tail, &t, t + 1,
+												  memory_order_acq_rel,
+												  memory_order_acquire))
+		{
+			DescCell *cell = &q->desc[t & q->mask];
+			*out = cell->d;
+			atomic_store_explicit(&cell->seq, t + q->capacity, memory_order_release);
+			return 1;
+		}
+	}
+}
 
-	int ok = 0;
-	pthread_mutex_lock(&q->mtx);
+// Pop com espera: o seq do notifier e lido antes de tentar o pop,
+// para um push entre o pop falhado e o wait nao se perder
+int desc_queue_pop_wait(DescQueue *q, AudioDesc *out, long timeout_ms)
+{
+	unsigned seen = notifier_seq(q->wake);
+	if (desc_queue_pop(q, out))
+		return 1;
+	notifier_wait(q->wake, seen, timeout_ms);
+	return desc_queue_pop(q, out);
+}
 
-	// Se tiver info descritor a processar
-	if (q->count > 0)
+// Round-robin para nenhuma fila ficar a frente das outras
+int desc_queue_pop_any(DescQueue *const *qs, int n, int *next, AudioDesc *out)
+{
+	for (int j = 0; j < n; j++)
 	{
-		*out = q->desc[q->tail];
-		q->tail = (q->tail + 1) % DESCRIPTOR_QUEUE_CAPACITY;
-		q->count--;
-		ok = 1;
+		int i = (*next + j) % n;
+		if (desc_queue_pop(qs[i], out))
+		{
+			*next = (i + 1) % n;
+			return i;
+		}
 	}
+	return -1;
+}
 
-	pthread_mutex_unlock(&q->mtx);
-	
-	return ok;
-}
\ No newline at end of file
+// Marca a fila como tendo consumidor
+// O dispatcher so publica nas filas subscritas; o notifier e trocado
+// antes de subscrever (ainda nao ha push nesta fila)
+void desc_queue_subscribe(DescQueue *q, Notifier *wake)
+{
+	q->wake = wake ? wake : &q->ready;
+	// release: o produtor que ve subscribed == 1 ve o novo wake
+	atomic_store_explicit(&q->subscribed, 1, memory_order_release);
+}
+
+unsigned desc_queue_size(DescQueue *q)
+{
+	unsigned t = atomic_load_explicit(&q->tail, memory_order_acquire);
+	unsigned h = atomic_load_explicit(&q->head, memory_order_acquire);
+	return h - t;
+}
+
+unsigned long desc_queue_dropped(DescQueue *q)
+{
+	return atomic_load_explicit(&q->dropped, memory_order_relaxed);
+}
@@ -1,100 +1,150 @@
 #include <stdio.h>
-#include <SDL.h>
+#include <string.h>
 #include "dispatcher.h"
 #include "desc_queue.h"
+#include "channel.h"
+#include "runtime.h"
 #include "audio_io.h"
-#include "lpf.h"
+#include "spectrum.h"
+#include "rt_stats.h"
+#include "time_utils.h"
+#include "rawrec.h"
+#include "rtlog.h"
 
-// NOTE - Thread
-// Criar variavel para guardar o identificador da thread
-pthread_t dispatcher_th;
-// Variável de controlo do estado da thread
-volatile int dispatcher_run = 1;
+// 0 = por eventos, 1 = periodico
+int periodic_mode = PERIODIC_MODE_DEFAULT;
 
-// Filas de descritores tem de ser static para poderem ser acedidas pelas threads
-static DescQueue q_speed;
-static DescQueue q_bearing;
-static DescQueue q_direction;
+// NOTE - Janela deslizante das analises
+// O espectro e calculado sobre as ultimas ANALYSIS_N amostras da taxa baixa
+// (com ANALYSIS_N maior do que um bloco decimado as janelas de blocos
+// seguidos sobrepoem-se)
+static void analysis_push(Channel *c, const float *y, int n)
+{
+    if (n > ANALYSIS_N)
+    {
+        y += n - ANALYSIS_N;
+        n = ANALYSIS_N;
+    }
+    memmove(c->analysis, c->analysis + n, sizeof(float) * (ANALYSIS_N - n));
+    memcpy(c->analysis + ANALYSIS_N - n, y, sizeof(float) * n);
+}
 
-// exposição controlada das filas do dispatcher 
-// para as threads consumidoras poderem aceder às respetivas filas
-DescQueue *dispatcher_get_speed_queue(void) {
-    return &q_speed;
+// Funcao para outros modulos obterem o n de blocos despachados
+// (o minimo dos canais: -n conta blocos por canal)
+int dispatcher_blocks_count(void) {
+    int n = -1;
+    for (int i = 0; i < gNumChannels; i++)
+    {
+        int b = atomic_load_explicit(&gChannels[i].blocks, memory_order_relaxed);
+        if (n < 0 || b < n)
+            n = b;
+    }
+    return n < 0 ? 0 : n;
 }
 
-DescQueue *dispatcher_get_bearing_queue(void)
+int dispatcher_blocks_total(void)
 {
-    return &q_bearing;
+    int n = 0;
+    for (int i = 0; i < gNumChannels; i++)
+        n += atomic_load_explicit(&gChannels[i].blocks, memory_order_relaxed);
+    return n;
 }
 
-DescQueue *dispatcher_get_direction_queue(void) {
-    return &q_direction;
+int dispatcher_init(void)
+{
+    if (gNumChannels < 1)
+        return -1;
+    printf("[SPECTRUM] N=%d, kernels %s\n", ANALYSIS_N, gChannels[0].spec.plan->k->name);
+    rt_stats_init(RT_DISPATCHER, "dispatcher", 0, -1);
+    return 0;
 }
 
-// variavel que determina o criterio de paragem de gravação
-static int blocksdispatched = 0;
-
-// Funao para outros modulos obterem o n de blocos despachados
-int dispatcher_blocks_count(void) {
-    return blocksdispatched;
+// NOTE - Publica um descritor numa fila
+// Se a fila descartar o descritor mais antigo, libertamos as referencias
+// desse consumidor ao espectro e ao bloco
+static void publish(DescQueue *q, AudioDesc d)
+{
+    AudioDesc old;
+    if (!desc_queue_push(q, d, &old))
+    {
+        spectrum_release(old.spec);
+        audio_release_buffer(old.ch, old.ptr);
+    }
 }
 
-// NOTE - Thread Dispatcher function
-// Lock e Unlock para evitar race condicions com a callback
-void *dispatcher_loop(void *arg)
+// NOTE - Filtra o bloco, calcula o espectro uma vez e publica nas filas do canal
+static void dispatch_block(Channel *c, AudioBuf *b, uint64_t start)
 {
-    // Evita o warning “unused parameter” porque a função
-    // de thread (pthread_create) tem de receber void *arg
-    (void)arg;
-
-    // se a thread é chamada, inicializamos as filas
-    desc_queue_init(&q_speed);
-    desc_queue_init(&q_bearing);
-    desc_queue_init(&q_direction);
+    AudioDesc d = {.ptr = b->data, .ch = c->id, .len = b->len, .seq = b->seq,
+                   .t_capture = b->t_capture, .t_dispatch = start};
 
-    while (dispatcher_run)
+    // Um descritor por analise registada; referencias do espectro e do
+    // bloco so para as analises que os usam
+    const int nsubs = runtime_analyses();
+    int nspec = 0, nblock = 0;
+    for (int a = 0; a < nsubs; a++)
     {
-        
-        // Temos de bloquear porque vamos mexer nos buffers
-        SDL_LockAudioDevice(gRecDev);
-        
-        if (bufA.full && !bufA.ready_to_consume)
-        {
-            
-            bufA.ready_to_consume = 1;
-            AudioDesc d = {.ptr = bufA.data, .len = ABUFSIZE_SAMPLES};
-            SDL_UnlockAudioDevice(gRecDev);
+        nspec += runtime_analysis(a)->uses_spectrum != 0;
+        nblock += runtime_analysis(a)->uses_block != 0;
+    }
 
-            // NOTE - Filtrar o bloco antes de fazer push
-            filterLP(CUTOFF_HZ, SAMP_FREQ, (uint8_t*)d.ptr, d.len);
+    // NOTE - Filtrar e decimar todos os blocos (mesmo sem consumidores) para
+    // o estado do filtro e a janela seguirem o sinal; tem de ser antes do
+    // dispatch, que pode devolver logo o bloco a pool quando nblock == 0
+    float *block = d.ptr;
+    iir_process_f32(&c->lpf, block, c->filtered, d.len);
+    int nlow = decim_process(&c->decim, c->filtered, d.len, c->lowrate);
+    analysis_push(c, c->lowrate, nlow);
+    // NOTE - Detetor do bearing por Goertzel
+    // So os bins LF e da banda do motor, atualizados a cada bloco com as amostras
+    // da taxa baixa: a decisao segue no descritor e nao espera pelo periodo do bearing
+    d.fault = bearing_bank_update(&c->bbank, c->lowrate, nlow);
+    d.lf_peak = c->bbank.lf_peak;
+    d.motor_peak = c->bbank.motor_peak;
 
-            desc_queue_push(&q_speed, d);
-            desc_queue_push(&q_bearing, d);
-            desc_queue_push(&q_direction, d);
-            blocksdispatched++;
-            //printf("[DISPATCH] push A (total=%d)\n", blocksdispatched);
-        }
-        else if (bufB.full && !bufB.ready_to_consume)
-        {
-            
-            bufB.ready_to_consume = 1;
-            AudioDesc d = {.ptr = bufB.data, .len = ABUFSIZE_SAMPLES};
-            SDL_UnlockAudioDevice(gRecDev);
-
-            // NOTE - Filtrar o bloco antes de fazer push
-            filterLP(CUTOFF_HZ, SAMP_FREQ, (uint8_t*)d.ptr, d.len);
+    // O bloco so volta a pool quando as nblock analises (e o gravador das
+    // falhas, se ativo) o libertarem
+    const int rec = rawrec_enabled();
+    buffer_pool_dispatch(&c->pool, b, nblock + rec);
+    if (rec)
+        rawrec_block(c->id, &c->pool, b);
+    if (nsubs > 0)
+    {
+        // NOTE - Estagio de espectro: FFT com janela Hann calculada uma só vez,
+        // sobre a janela da taxa baixa
+        Spectrum *spec = spectrum_compute(&c->spec, c->analysis, ANALYSIS_FS, nspec);
 
-            desc_queue_push(&q_speed, d);
-            desc_queue_push(&q_bearing, d);
-            desc_queue_push(&q_direction, d);
-            blocksdispatched++;
-            printf("[DISPATCH] push B (total=%d)\n", blocksdispatched);
-        }
-        else
+        // Uma tarefa por analise (no modo por eventos; no periodico as
+        // tarefas sao libertadas pelo periodo)
+        d.t_ready = now_ns();
+        for (int a = 0; a < nsubs; a++)
         {
-            SDL_UnlockAudioDevice(gRecDev);
-            SDL_Delay(2);
+            const Analysis *an = runtime_analysis(a);
+            d.spec = an->uses_spectrum ? spec : NULL;
+            d.ptr = an->uses_block ? block : NULL;
+            publish(&c->q[a], d);
+            if (!periodic_mode)
+                runtime_notify(a, c->id);
         }
     }
-    return NULL;
-}
\ No newline at end of file
+
+    int total = atomic_fetch_add_explicit(&c->blocks, 1, memory_order_relaxed) + 1;
+    RTLOG(RTLOG_DEBUG, "[DISPATCH] push ch=%d seq=%u (blocks=%d)\n", c->id, d.seq, total);
+}
+
+// NOTE - Dispatch de um bloco
+// O anel dos cheios e lock-free: nao ha lock do dispositivo contra a callback
+int dispatcher_dispatch(Channel *c)
+{
+    AudioBuf *b = buffer_pool_next_full(&c->pool);
+    if (!b)
+        return 0;
+
+    // Libertado pela captura do bloco; tem de acabar antes de chegar o seguinte
+    RtStats *st = &gRtStats[RT_DISPATCHER];
+    uint64_t start = rt_activation_begin(st, b->t_capture);
+    uint64_t deadline = b->t_capture + 1000000000ull * ABUFSIZE_SAMPLES / SAMP_FREQ;
+    dispatch_block(c, b, start);
+    rt_activation_end(st, start, deadline);
+    return 1;
+}
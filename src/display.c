@@ -3,11 +3,16 @@
 #include "display.h"
 #include "time_utils.h"
 #include "rtdb.h"
+#include "rt_stats.h"
+#include "rtlog.h"
 
 volatile int display_run = 1;
 pthread_t display_th;
 static RTDB *g_db = NULL;
 
+// blocos recentes em que se contam as falhas do bearing (historico da RTDB)
+#define DISPLAY_FAULT_BLOCKS 16
+
 void display_set_rtdb(RTDB *db) { g_db = db; }
 
 void *display_loop(void *arg)
@@ -16,19 +21,41 @@ void *display_loop(void *arg)
     const long PERIOD_MS = 300;
     struct timespec next_time;
     clock_gettime(CLOCK_MONOTONIC, &next_time);
+    rt_stats_init(RT_DISPLAY, "display", PERIOD_MS, -1);
+    RtStats *st = &gRtStats[RT_DISPLAY];
     while (display_run)
     {
+        uint64_t start = rt_activation_begin(st, ts_to_ns(&next_time));
         add_ms(&next_time, PERIOD_MS);
         if (g_db)
         {
-            float hz = rtdb_get_speed(g_db);
-            float rpm = hz * 60.0f;
-            int fault = rtdb_get_bearing_fault(g_db);
+            // Uma linha por canal (motor): ultimo valor, idade desde a
+            // captura do bloco que o produziu e falhas nos ultimos blocos
+            uint64_t now = now_ns();
+            for (int c = 0; c < g_db->nch; c++)
+            {
+                RtdbSample sp, hist[DISPLAY_FAULT_BLOCKS];
+                int r = rtdb_read(g_db, RTDB_SPEED, c, &sp);
+                if (r <= 0)
+                {
+                    RTLOG(RTLOG_INFO, "[DISPLAY] ch %d speed: %s\n", c, r < 0 ? "busy" : "-");
+                    continue;
+                }
+                int n = rtdb_history(g_db, RTDB_BEARING, c, hist, DISPLAY_FAULT_BLOCKS);
+                if (n < 0)
+                    n = 0;
+                int faults = 0;
+                for (int i = 0; i < n; i++)
+                    faults += hist[i].fault;
+                float rpm = sp.speed_hz * 60.0f;
 
-            printf("[DISPLAY] speed: %.1f Hz (%.0f rpm) | bearing: %s\n",
-                   hz, rpm, fault ? "FAULT" : "OK");
+                RTLOG(RTLOG_INFO, "[DISPLAY] ch %d speed: %.1f Hz (%.0f rpm) block %u age %.1f ms | bearing: %s (%d/%d)\n",
+                      c, sp.speed_hz, rpm, sp.block, (now - sp.t_capture) / 1e6,
+                      n > 0 && hist[0].fault ? "FAULT" : "OK", faults, n);
+            }
         }
+        rt_activation_end(st, start, ts_to_ns(&next_time));
         clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next_time, NULL);
     }
     return NULL;
-}
\ No newline at end of file
+}
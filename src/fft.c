@@ -4,22 +4,21 @@
  * 
  * C module to compute the Fast Fourier Transform (FFT) of an array
  * using the (recursive) Cooley-Tukey algorithm.  
+ * Also provides an iterative, in-place version driven by FFT plans
+ * (precomputed twiddle and bit-reversal tables).
  
  * ************************************************************/
 
-#ifndef FFT_H
-#define FFT_H
-
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
 #endif
 
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <math.h>
 #include <complex.h>
 #include "fft.h"
-#include <SDL2/SDL_stdinc.h>
 
 /* *******************************************************************
  * Function to perform the FFT (recursive version) 
@@ -49,6 +48,194 @@ void fftCompute(complex double *X, int N) {
     }
 }
 
+/* *******************************************************************
+ * Complex product written out by hand: the C99 operator also handles
+ * inf/nan cases (__muldc3), which is much slower in the inner loops
+ * *******************************************************************/
+static inline complex double cmul(complex double a, complex double b) {
+    double ar = creal(a), ai = cimag(a);
+    double br = creal(b), bi = cimag(b);
+    return CMPLX(ar * br - ai * bi, ar * bi + ai * br);
+}
+
+/* *******************************************************************
+ * FFT plan: twiddle and bit-reversal tables for size N
+ * *******************************************************************/
+FFTPlan *fftPlanCreate(int N) {
+
+    if (N < 1 || (N & (N - 1)) != 0) return NULL;	// N must be a power of 2
+
+    FFTPlan *p = calloc(1, sizeof(*p));
+    if (!p) return NULL;
+
+    p->N = N;
+    while ((1 << p->log2N) < N) p->log2N++;
+
+    p->rev = malloc(sizeof(int) * N);
+    p->tw = malloc(sizeof(complex double) * (N / 2 > 0 ? N / 2 : 1));
+    if (!p->rev || !p->tw) {
+        fftPlanDestroy(p);
+        return NULL;
+    }
+
+    for (int i = 0; i < N; i++) {
+        int r = 0;
+        for (int b = 0; b < p->log2N; b++)
+            if (i & (1 << b)) r |= 1 << (p->log2N - 1 - b);
+        p->rev[i] = r;
+    }
+
+    /* Each twiddle is computed directly (not by recurrence) to avoid
+     * accumulating rounding errors */
+    for (int k = 0; k < N / 2; k++)
+        p->tw[k] = CMPLX(cos(2.0 * M_PI * k / N), -sin(2.0 * M_PI * k / N));
+
+    return p;
+}
+
+void fftPlanDestroy(FFTPlan *p) {
+    if (!p) return;
+    free(p->rev);
+    free(p->tw);
+    free(p);
+}
+
+/* *******************************************************************
+ * FFT (iterative, in-place version)
+ * Decimation in time: the input is put in bit-reversed order and the
+ * butterflies are then applied from the smallest to the largest size.
+ * Two consecutive radix-2 stages are fused in one radix-4 pass, so the
+ * array is traversed log2(N)/2 times instead of log2(N).
+ * *******************************************************************/
+void fftPlanExecute(const FFTPlan *p, complex double *X) {
+
+    const int N = p->N;
+    const complex double *tw = p->tw;
+    int m = 1;	// half size of the butterflies of the next stage
+
+    // Bit-reversal permutation
+    for (int i = 0; i < N; i++) {
+        int r = p->rev[i];
+        if (i < r) {
+            complex double t = X[i];
+            X[i] = X[r];
+            X[r] = t;
+        }
+    }
+
+    // Odd number of stages: one radix-2 pass of size 2 (twiddle = 1)
+    if (p->log2N & 1) {
+        for (int k = 0; k < N; k += 2) {
+            complex double a = X[k];
+            complex double b = X[k + 1];
+            X[k]     = a + b;
+            X[k + 1] = a - b;
+        }
+        m = 2;
+    }
+
+    // Radix-4 passes: stage of size 2m followed by stage of size 4m
+    for (; 4 * m <= N; m *= 4) {
+        const int s1 = N / (2 * m);	// stride in tw[] for W_2m
+        const int s2 = N / (4 * m);	// stride in tw[] for W_4m
+
+        for (int k = 0; k < N; k += 4 * m) {
+            for (int j = 0; j < m; j++) {
+                complex double w1 = tw[j * s1];
+                complex double w2 = tw[j * s2];
+                // W_4m^(j+m) = -i * W_4m^j
+                complex double w3 = CMPLX(cimag(w2), -creal(w2));
+
+                complex double a0 = X[k + j];
+                complex double a1 = X[k + j + m];
+                complex double a2 = X[k + j + 2 * m];
+                complex double a3 = X[k + j + 3 * m];
+
+                complex double t = cmul(w1, a1);
+                complex double b0 = a0 + t;
+                complex double b1 = a0 - t;
+                t = cmul(w1, a3);
+                complex double b2 = a2 + t;
+                complex double b3 = a2 - t;
+
+                t = cmul(w2, b2);
+                X[k + j]         = b0 + t;
+                X[k + j + 2 * m] = b0 - t;
+                t = cmul(w3, b3);
+                X[k + j + m]     = b1 + t;
+                X[k + j + 3 * m] = b1 - t;
+            }
+        }
+    }
+}
+
+/* *******************************************************************
+ * Real-input FFT plan: complex plan of size N/2 plus the twiddles
+ * used to split the packed transform
+ * *******************************************************************/
+FFTRealPlan *fftRealPlanCreate(int N) {
+
+    if (N < 2 || (N & (N - 1)) != 0) return NULL;
+
+    FFTRealPlan *p = calloc(1, sizeof(*p));
+    if (!p) return NULL;
+
+    p->N = N;
+    p->half = fftPlanCreate(N / 2);
+    p->tw = malloc(sizeof(complex double) * (N / 4 + 1));
+    if (!p->half || !p->tw) {
+        fftRealPlanDestroy(p);
+        return NULL;
+    }
+
+    for (int k = 0; k <= N / 4; k++)
+        p->tw[k] = CMPLX(cos(2.0 * M_PI * k / N), -sin(2.0 * M_PI * k / N));
+
+    return p;
+}
+
+void fftRealPlanDestroy(FFTRealPlan *p) {
+    if (!p) return;
+    fftPlanDestroy(p->half);
+    free(p->tw);
+    free(p);
+}
+
+/* *******************************************************************
+ * Real-input FFT
+ * With Z = FFT(z) of size M = N/2, the even and odd sample spectra are
+ *    Ze[k] = (Z[k] + conj(Z[M-k])) / 2
+ *    Zo[k] = -i * (Z[k] - conj(Z[M-k])) / 2
+ * and X[k] = Ze[k] + W_N^k * Zo[k]. Bins k and M-k use the same pair
+ * Z[k], Z[M-k], so both are computed together and written in place:
+ *    X[M-k] = conj(Ze[k] - W_N^k * Zo[k])
+ * *******************************************************************/
+void fftRealExecute(const FFTRealPlan *p, const double *x, complex double *Y) {
+
+    const int M = p->N / 2;
+
+    for (int n = 0; n < M; n++)
+        Y[n] = CMPLX(x[2 * n], x[2 * n + 1]);
+
+    fftPlanExecute(p->half, Y);
+
+    // DC and fs/2 are both real
+    double r0 = creal(Y[0]), i0 = cimag(Y[0]);
+    Y[0] = CMPLX(r0 + i0, 0.0);
+    Y[M] = CMPLX(r0 - i0, 0.0);
+
+    for (int k = 1; k <= M / 2; k++) {
+        complex double A = Y[k];
+        complex double B = conj(Y[M - k]);
+        complex double ze = 0.5 * (A + B);
+        complex double d = 0.5 * (A - B);
+        complex double zo = CMPLX(cimag(d), -creal(d));	// -i * d
+        complex double t = cmul(p->tw[k], zo);
+        Y[k]     = ze + t;
+        Y[M - k] = conj(ze - t);
+    }
+}
+
 /* **********************************************************
  *  Converts complex representation of FFT in amplitudes.
  *  Also generates the corresponding frequencies 
@@ -78,6 +265,20 @@ void fftGetAmplitude(complex double * X, int N, int fs, float * fk, float * Ak)
 	return;    
 }
 
+/* **********************************************************
+ *  Amplitudes of the N/2+1 bins of a real-input FFT
+ * **********************************************************/
+void fftGetAmplitudeReal(const complex double *Y, int N, int fs, float *fk, float *Ak) {
+
+    for (int k = 0; k <= N / 2; k++)
+        fk[k] = (float)k * (float)fs / (float)N;
+
+    Ak[0] = (float)(cabs(Y[0]) / N);
+    Ak[N/2] = (float)(cabs(Y[N/2]) / N);
+    for (int k = 1; k < N/2; k++)
+        Ak[k] = (float)(2.0 * cabs(Y[k]) / N);
+}
+
 /* ******************************************************
  *  Helper function to print complex arrays
   * ******************************************************/
@@ -86,5 +287,3 @@ void printComplexArray(complex double *X, int N) {
         printf("%g + %gi\n", creal(X[i]), cimag(X[i]));
     }
 }
-
-#endif
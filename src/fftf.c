@@ -0,0 +1,262 @@
+/* *******************************************************************
+ * FFT real em float32 (formato split) e kernels de espectro
+ *
+ * Mesmo algoritmo que fftRealExecute (fft.c): as N amostras reais sao
+ * empacotadas em N/2 complexos, transformadas por estagios radix-2 DIT
+ * e depois separadas nos bins 0..N/2 do sinal real.
+ * Os estagios, as amplitudes e a procura de picos usam a tabela de
+ * kernels escolhida no arranque (ver fftf_sse2.c e fftf_avx2.c).
+ * *******************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "fftf.h"
+#include "config.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define FFTF_X86 1
+extern const FFTFKernels fftf_kernels_sse2;
+extern const FFTFKernels fftf_kernels_avx2;
+#endif
+
+// NOTE - Kernels escalares (portaveis)
+static void pass_scalar(float *re, float *im, const float *tw_re, const float *tw_im,
+						int M, int m)
+{
+	for (int k = 0; k < M; k += 2 * m)
+	{
+		for (int j = 0; j < m; j++)
+		{
+			float wr = tw_re[j], wi = tw_im[j];
+			float br = re[k + j + m], bi = im[k + j + m];
+			float tr = wr * br - wi * bi;
+			float ti = wr * bi + wi * br;
+			float ar = re[k + j], ai = im[k + j];
+			re[k + j] = ar + tr;
+			im[k + j] = ai + ti;
+			re[k + j + m] = ar - tr;
+			im[k + j + m] = ai - ti;
+		}
+	}
+}
+
+static void magnitude_scalar(const float *re, const float *im, float *out, int n, float scale)
+{
+	for (int k = 0; k < n; k++)
+		out[k] = scale * sqrtf(re[k] * re[k] + im[k] * im[k]);
+}
+
+static int peak_scalar(const float *x, int begin, int end)
+{
+	int best = -1;
+	for (int k = begin; k < end; k++)
+		if (best < 0 || x[k] > x[best])
+			best = k;
+	return best;
+}
+
+static const FFTFKernels kernels_scalar = {
+	.name = "scalar",
+	.width = 1,
+	.fft_pass = pass_scalar,
+	.magnitude = magnitude_scalar,
+	.peak = peak_scalar,
+};
+
+// NOTE - Seleção da variante
+const FFTFKernels *fftfKernels(FFTFIsa isa)
+{
+	switch (isa)
+	{
+	case FFTF_ISA_SCALAR:
+		return &kernels_scalar;
+#ifdef FFTF_X86
+	case FFTF_ISA_SSE2:
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("sse2") ? &fftf_kernels_sse2 : NULL;
+	case FFTF_ISA_AVX2:
+		// __builtin_cpu_supports usa o CPUID (e confirma o suporte do SO ao AVX)
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+			return &fftf_kernels_avx2;
+		return NULL;
+#endif
+	default:
+		return NULL;
+	}
+}
+
+const FFTFKernels *fftfBestKernels(void)
+{
+	// Escolhida uma vez (no arranque, por spectrum_init)
+	static const FFTFKernels *best = NULL;
+	if (!best)
+	{
+		const FFTFKernels *k = NULL;
+		for (int isa = FFTF_ISA_COUNT - 1; isa >= 0 && !k; isa--)
+			k = fftfKernels((FFTFIsa)isa);
+		best = k;
+	}
+	return best;
+}
+
+// NOTE - Plan
+static void *alloc_aligned(size_t n)
+{
+	// aligned_alloc exige tamanho multiplo do alinhamento
+	size_t sz = (n + 31) & ~(size_t)31;
+	void *p = aligned_alloc(32, sz);
+	if (p)
+		memset(p, 0, sz);
+	return p;
+}
+
+FFTFPlan *fftfPlanCreate(int N, const FFTFKernels *k)
+{
+	if (N < 4 || (N & (N - 1)) != 0)
+		return NULL;
+
+	FFTFPlan *p = calloc(1, sizeof(*p));
+	if (!p)
+		return NULL;
+
+	p->N = N;
+	p->M = N / 2;
+	p->k = k ? k : fftfBestKernels();
+
+	const int M = p->M;
+	p->rev = malloc(sizeof(int) * M);
+	p->tw_re = alloc_aligned(sizeof(float) * M);
+	p->tw_im = alloc_aligned(sizeof(float) * M);
+	p->sp_re = alloc_aligned(sizeof(float) * (M / 2 + 1));
+	p->sp_im = alloc_aligned(sizeof(float) * (M / 2 + 1));
+	p->re = alloc_aligned(sizeof(float) * (M + 1));
+	p->im = alloc_aligned(sizeof(float) * (M + 1));
+	if (!p->rev || !p->tw_re || !p->tw_im || !p->sp_re || !p->sp_im || !p->re || !p->im)
+	{
+		fftfPlanDestroy(p);
+		return NULL;
+	}
+
+	int log2M = 0;
+	while ((1 << log2M) < M)
+		log2M++;
+	for (int i = 0; i < M; i++)
+	{
+		int r = 0;
+		for (int b = 0; b < log2M; b++)
+			if (i & (1 << b))
+				r |= 1 << (log2M - 1 - b);
+		p->rev[i] = r;
+	}
+
+	// Twiddles calculados em double e so depois arredondados
+	for (int m = 1; m < M; m *= 2)
+	{
+		for (int j = 0; j < m; j++)
+		{
+			p->tw_re[m + j] = (float)cos(M_PI * j / m);
+			p->tw_im[m + j] = (float)-sin(M_PI * j / m);
+		}
+	}
+	for (int j = 0; j <= M / 2; j++)
+	{
+		p->sp_re[j] = (float)cos(2.0 * M_PI * j / N);
+		p->sp_im[j] = (float)-sin(2.0 * M_PI * j / N);
+	}
+
+	return p;
+}
+
+void fftfPlanDestroy(FFTFPlan *p)
+{
+	if (!p)
+		return;
+	free(p->rev);
+	free(p->tw_re);
+	free(p->tw_im);
+	free(p->sp_re);
+	free(p->sp_im);
+	free(p->re);
+	free(p->im);
+	free(p);
+}
+
+// NOTE - FFT real
+void fftfRealExecute(FFTFPlan *p, const float *x)
+{
+	const int M = p->M;
+	float *re = p->re;
+	float *im = p->im;
+
+	// Empacotar z[n] = x[2n] + i*x[2n+1] ja na ordem bit-reversal
+	for (int n = 0; n < M; n++)
+	{
+		int r = p->rev[n];
+		re[r] = x[2 * n];
+		im[r] = x[2 * n + 1];
+	}
+
+	// Estagios m=1 e m=2 juntos (twiddles 1 e -i, sem multiplicacoes)
+	int m = 1;
+	if (M >= 4)
+	{
+		for (int k = 0; k < M; k += 4)
+		{
+			float b0r = re[k] + re[k + 1], b0i = im[k] + im[k + 1];
+			float b1r = re[k] - re[k + 1], b1i = im[k] - im[k + 1];
+			float b2r = re[k + 2] + re[k + 3], b2i = im[k + 2] + im[k + 3];
+			float b3r = re[k + 2] - re[k + 3], b3i = im[k + 2] - im[k + 3];
+			re[k] = b0r + b2r;
+			im[k] = b0i + b2i;
+			re[k + 2] = b0r - b2r;
+			im[k + 2] = b0i - b2i;
+			// -i * b3 = b3i - i*b3r
+			re[k + 1] = b1r + b3i;
+			im[k + 1] = b1i - b3r;
+			re[k + 3] = b1r - b3i;
+			im[k + 3] = b1i + b3r;
+		}
+		m = 4;
+	}
+
+	// Restantes estagios radix-2; os mais pequenos que a largura do vetor sao escalares
+	for (; m < M; m *= 2)
+	{
+		const FFTFKernels *k = (m >= p->k->width) ? p->k : &kernels_scalar;
+		k->fft_pass(re, im, p->tw_re + m, p->tw_im + m, M, m);
+	}
+
+	// Separar o espectro real (ver fftRealExecute)
+	float r0 = re[0], i0 = im[0];
+	re[0] = r0 + i0;
+	im[0] = 0.0f;
+	re[M] = r0 - i0;
+	im[M] = 0.0f;
+
+	for (int k = 1; k <= M / 2; k++)
+	{
+		float ar = re[k], ai = im[k];
+		float br = re[M - k], bi = -im[M - k]; // conj(Z[M-k])
+		float ze_r = 0.5f * (ar + br), ze_i = 0.5f * (ai + bi);
+		float d_r = 0.5f * (ar - br), d_i = 0.5f * (ai - bi);
+		float zo_r = d_i, zo_i = -d_r; // -i * d
+		float wr = p->sp_re[k], wi = p->sp_im[k];
+		float t_r = wr * zo_r - wi * zo_i;
+		float t_i = wr * zo_i + wi * zo_r;
+		re[k] = ze_r + t_r;
+		im[k] = ze_i + t_i;
+		re[M - k] = ze_r - t_r;
+		im[M - k] = -(ze_i - t_i);
+	}
+}
+
+void fftfAmplitude(const FFTFPlan *p, float *amp, float gain)
+{
+	const int M = p->M;
+	p->k->magnitude(p->re, p->im, amp, M + 1, 2.0f * gain);
+	// DC e fs/2 nao sao espelhados
+	amp[0] = gain * fabsf(p->re[0]);
+	amp[M] = gain * fabsf(p->re[M]);
+}
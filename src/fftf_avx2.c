@@ -0,0 +1,112 @@
+/* *******************************************************************
+ * Kernels AVX2 + FMA (8 floats por instrucao) para fftf.c
+ * Compilado com -mavx2 -mfma (ver Makefile); so e usado se o CPUID
+ * indicar suporte (fftfKernels)
+ * *******************************************************************/
+#include "fftf.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <math.h>
+#include <immintrin.h>
+
+static void pass_avx2(float *re, float *im, const float *tw_re, const float *tw_im,
+					  int M, int m)
+{
+	// m >= 8 (width)
+	for (int k = 0; k < M; k += 2 * m)
+	{
+		float *ar = re + k, *ai = im + k;
+		float *br = re + k + m, *bi = im + k + m;
+		for (int j = 0; j < m; j += 8)
+		{
+			__m256 wr = _mm256_loadu_ps(tw_re + j);
+			__m256 wi = _mm256_loadu_ps(tw_im + j);
+			__m256 xr = _mm256_loadu_ps(br + j);
+			__m256 xi = _mm256_loadu_ps(bi + j);
+			__m256 tr = _mm256_fmsub_ps(wr, xr, _mm256_mul_ps(wi, xi));
+			__m256 ti = _mm256_fmadd_ps(wr, xi, _mm256_mul_ps(wi, xr));
+			__m256 yr = _mm256_loadu_ps(ar + j);
+			__m256 yi = _mm256_loadu_ps(ai + j);
+			_mm256_storeu_ps(ar + j, _mm256_add_ps(yr, tr));
+			_mm256_storeu_ps(ai + j, _mm256_add_ps(yi, ti));
+			_mm256_storeu_ps(br + j, _mm256_sub_ps(yr, tr));
+			_mm256_storeu_ps(bi + j, _mm256_sub_ps(yi, ti));
+		}
+	}
+}
+
+static void magnitude_avx2(const float *re, const float *im, float *out, int n, float scale)
+{
+	const __m256 s = _mm256_set1_ps(scale);
+	int k = 0;
+	for (; k + 8 <= n; k += 8)
+	{
+		__m256 r = _mm256_loadu_ps(re + k);
+		__m256 i = _mm256_loadu_ps(im + k);
+		__m256 p = _mm256_fmadd_ps(r, r, _mm256_mul_ps(i, i));
+		_mm256_storeu_ps(out + k, _mm256_mul_ps(s, _mm256_sqrt_ps(p)));
+	}
+	for (; k < n; k++)
+		out[k] = scale * sqrtf(re[k] * re[k] + im[k] * im[k]);
+}
+
+static int peak_avx2(const float *x, int begin, int end)
+{
+	if (end <= begin)
+		return -1;
+
+	int k = begin;
+	int best = begin;
+	float vbest = x[begin];
+
+	if (end - begin >= 16)
+	{
+		__m256 vmax = _mm256_loadu_ps(x + k);
+		__m256 cur = _mm256_add_ps(_mm256_set1_ps((float)k),
+								   _mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7));
+		__m256 vidx = cur;
+		const __m256 eight = _mm256_set1_ps(8.0f);
+		for (k += 8; k + 8 <= end; k += 8)
+		{
+			cur = _mm256_add_ps(cur, eight);
+			__m256 v = _mm256_loadu_ps(x + k);
+			__m256 gt = _mm256_cmp_ps(v, vmax, _CMP_GT_OQ);
+			vmax = _mm256_blendv_ps(vmax, v, gt);
+			vidx = _mm256_blendv_ps(vidx, cur, gt);
+		}
+
+		float m[8], id[8];
+		_mm256_storeu_ps(m, vmax);
+		_mm256_storeu_ps(id, vidx);
+		vbest = m[0];
+		best = (int)id[0];
+		for (int l = 1; l < 8; l++)
+		{
+			if (m[l] > vbest || (m[l] == vbest && (int)id[l] < best))
+			{
+				vbest = m[l];
+				best = (int)id[l];
+			}
+		}
+	}
+
+	for (; k < end; k++)
+	{
+		if (x[k] > vbest)
+		{
+			vbest = x[k];
+			best = k;
+		}
+	}
+	return best;
+}
+
+const FFTFKernels fftf_kernels_avx2 = {
+	.name = "avx2",
+	.width = 8,
+	.fft_pass = pass_avx2,
+	.magnitude = magnitude_avx2,
+	.peak = peak_avx2,
+};
+
+#endif
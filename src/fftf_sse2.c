@@ -0,0 +1,111 @@
+/* *******************************************************************
+ * Kernels SSE2 (4 floats por instrucao) para fftf.c
+ * O SSE2 faz parte da base x86-64, nao precisa de flags extra
+ * *******************************************************************/
+#include "fftf.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <math.h>
+#include <emmintrin.h>
+
+static void pass_sse2(float *re, float *im, const float *tw_re, const float *tw_im,
+					  int M, int m)
+{
+	// m >= 4 (width): os j de cada butterfly sao contiguos
+	for (int k = 0; k < M; k += 2 * m)
+	{
+		float *ar = re + k, *ai = im + k;
+		float *br = re + k + m, *bi = im + k + m;
+		for (int j = 0; j < m; j += 4)
+		{
+			__m128 wr = _mm_loadu_ps(tw_re + j);
+			__m128 wi = _mm_loadu_ps(tw_im + j);
+			__m128 xr = _mm_loadu_ps(br + j);
+			__m128 xi = _mm_loadu_ps(bi + j);
+			__m128 tr = _mm_sub_ps(_mm_mul_ps(wr, xr), _mm_mul_ps(wi, xi));
+			__m128 ti = _mm_add_ps(_mm_mul_ps(wr, xi), _mm_mul_ps(wi, xr));
+			__m128 yr = _mm_loadu_ps(ar + j);
+			__m128 yi = _mm_loadu_ps(ai + j);
+			_mm_storeu_ps(ar + j, _mm_add_ps(yr, tr));
+			_mm_storeu_ps(ai + j, _mm_add_ps(yi, ti));
+			_mm_storeu_ps(br + j, _mm_sub_ps(yr, tr));
+			_mm_storeu_ps(bi + j, _mm_sub_ps(yi, ti));
+		}
+	}
+}
+
+static void magnitude_sse2(const float *re, const float *im, float *out, int n, float scale)
+{
+	const __m128 s = _mm_set1_ps(scale);
+	int k = 0;
+	for (; k + 4 <= n; k += 4)
+	{
+		__m128 r = _mm_loadu_ps(re + k);
+		__m128 i = _mm_loadu_ps(im + k);
+		__m128 p = _mm_add_ps(_mm_mul_ps(r, r), _mm_mul_ps(i, i));
+		_mm_storeu_ps(out + k, _mm_mul_ps(s, _mm_sqrt_ps(p)));
+	}
+	for (; k < n; k++)
+		out[k] = scale * sqrtf(re[k] * re[k] + im[k] * im[k]);
+}
+
+static int peak_sse2(const float *x, int begin, int end)
+{
+	if (end <= begin)
+		return -1;
+
+	int k = begin;
+	int best = begin;
+	float vbest = x[begin];
+
+	if (end - begin >= 8)
+	{
+		// Maximo e indice por lane; comparacao estrita mantem o primeiro indice
+		__m128 vmax = _mm_loadu_ps(x + k);
+		__m128 vidx = _mm_setr_ps((float)k, (float)(k + 1), (float)(k + 2), (float)(k + 3));
+		__m128 cur = vidx;
+		const __m128 four = _mm_set1_ps(4.0f);
+		for (k += 4; k + 4 <= end; k += 4)
+		{
+			cur = _mm_add_ps(cur, four);
+			__m128 v = _mm_loadu_ps(x + k);
+			__m128 gt = _mm_cmpgt_ps(v, vmax);
+			vmax = _mm_or_ps(_mm_and_ps(gt, v), _mm_andnot_ps(gt, vmax));
+			vidx = _mm_or_ps(_mm_and_ps(gt, cur), _mm_andnot_ps(gt, vidx));
+		}
+
+		float m[4], id[4];
+		_mm_storeu_ps(m, vmax);
+		_mm_storeu_ps(id, vidx);
+		vbest = m[0];
+		best = (int)id[0];
+		for (int l = 1; l < 4; l++)
+		{
+			if (m[l] > vbest || (m[l] == vbest && (int)id[l] < best))
+			{
+				vbest = m[l];
+				best = (int)id[l];
+			}
+		}
+	}
+
+	for (; k < end; k++)
+	{
+		if (x[k] > vbest)
+		{
+			vbest = x[k];
+			best = k;
+		}
+	}
+	return best;
+}
+
+const FFTFKernels fftf_kernels_sse2 = {
+	.name = "sse2",
+	.width = 4,
+	.fft_pass = pass_sse2,
+	.magnitude = magnitude_sse2,
+	.peak = peak_sse2,
+};
+
+#endif
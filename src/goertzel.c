@@ -0,0 +1,263 @@
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "goertzel.h"
+#include "config.h"
+
+typedef float goertzel_vf __attribute__((vector_size(GOERTZEL_VEC * sizeof(float))));
+
+#define GOERTZEL_INLINE static inline __attribute__((always_inline))
+// vetores processados em conjunto (cadeias de dependencias independentes)
+// run_body tem as GOERTZEL_CHAINS cadeias escritas por extenso
+#define GOERTZEL_CHAINS 4
+
+// NOTE - Recorrencias de GOERTZEL_CHAINS vetores de bins de cada vez
+// s = fma(c, s1, x - s2): x - s2 nao depende da amostra anterior,
+// a cadeia critica e so o fma
+GOERTZEL_INLINE void run_body(GoertzelBank *b)
+{
+	const int N = b->N;
+	const float *xw = b->xw;
+	for (int v = 0; v < b->nv; v += GOERTZEL_CHAINS)
+	{
+		goertzel_vf c0, c1, c2, c3;
+		const float *cv = b->coef + v * GOERTZEL_VEC;
+		memcpy(&c0, cv, sizeof(c0));
+		memcpy(&c1, cv + GOERTZEL_VEC, sizeof(c1));
+		memcpy(&c2, cv + 2 * GOERTZEL_VEC, sizeof(c2));
+		memcpy(&c3, cv + 3 * GOERTZEL_VEC, sizeof(c3));
+		goertzel_vf a0 = {0}, a1 = {0}, a2 = {0}, a3 = {0}; // s1
+		goertzel_vf b0 = {0}, b1 = {0}, b2 = {0}, b3 = {0}; // s2
+		for (int i = 0; i < N; i++)
+		{
+			const float x = xw[i];
+			goertzel_vf t0 = c0 * a0 + (x - b0);
+			goertzel_vf t1 = c1 * a1 + (x - b1);
+			goertzel_vf t2 = c2 * a2 + (x - b2);
+			goertzel_vf t3 = c3 * a3 + (x - b3);
+			b0 = a0, b1 = a1, b2 = a2, b3 = a3;
+			a0 = t0, a1 = t1, a2 = t2, a3 = t3;
+		}
+		goertzel_vf p[GOERTZEL_CHAINS] = {
+			a0 * a0 + b0 * b0 - c0 * a0 * b0,
+			a1 * a1 + b1 * b1 - c1 * a1 * b1,
+			a2 * a2 + b2 * b2 - c2 * a2 * b2,
+			a3 * a3 + b3 * b3 - c3 * a3 * b3};
+		memcpy(b->amp + v * GOERTZEL_VEC, p, sizeof(p));
+	}
+}
+
+static void run_generic(GoertzelBank *b)
+{
+	run_body(b);
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+// Mesmo codigo compilado para AVX2+FMA (escolhido via CPUID em goertzel_init)
+__attribute__((target("avx2,fma"))) static void run_avx2(GoertzelBank *b)
+{
+	run_body(b);
+}
+#endif
+
+int goertzel_init(GoertzelBank *b, int N, int k0, int k1)
+{
+	memset(b, 0, sizeof(*b));
+	if (N < 2 || k0 < 0 || k1 <= k0 || k1 > N / 2 + 1)
+		return -1;
+
+	b->N = N;
+	b->k0 = k0;
+	b->nb = k1 - k0;
+	// n de vetores arredondado as cadeias; as lanes extra repetem k0
+	const int per = GOERTZEL_VEC * GOERTZEL_CHAINS;
+	b->nv = (b->nb + per - 1) / per * GOERTZEL_CHAINS;
+	const int nl = b->nv * GOERTZEL_VEC;
+
+	b->coef = aligned_alloc(32, sizeof(float) * nl);
+	b->amp = aligned_alloc(32, sizeof(float) * nl);
+	b->window = aligned_alloc(32, sizeof(float) * ((N + 7) & ~7));
+	b->xw = aligned_alloc(32, sizeof(float) * ((N + 7) & ~7));
+	if (!b->coef || !b->amp || !b->window || !b->xw)
+	{
+		goertzel_destroy(b);
+		return -1;
+	}
+
+	for (int l = 0; l < nl; l++)
+	{
+		const int k = l < b->nb ? k0 + l : k0;
+		b->coef[l] = (float)(2.0 * cos(2.0 * M_PI * k / N));
+	}
+
+	// Mesma janela e normalizacao que o spectrum
+	double window_sum = 0.0;
+	for (int i = 0; i < N; i++)
+	{
+		b->window[i] = (float)(0.5 * (1.0 - cos(2.0 * M_PI * i / (N - 1))));
+		window_sum += b->window[i];
+	}
+	b->gain = (float)(1.0 / window_sum);
+
+	b->run = run_generic;
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+		b->run = run_avx2;
+#endif
+	return 0;
+}
+
+void goertzel_destroy(GoertzelBank *b)
+{
+	free(b->coef);
+	free(b->amp);
+	free(b->window);
+	free(b->xw);
+	b->coef = b->amp = b->window = b->xw = NULL;
+}
+
+void goertzel_compute(GoertzelBank *b, const float *x)
+{
+	for (int i = 0; i < b->N; i++)
+		b->xw[i] = x[i] * b->window[i];
+	b->run(b);
+
+	// |X_k|^2 -> amplitude de pico: 2|X|/sum(w), exceto DC e fs/2
+	for (int l = 0; l < b->nb; l++)
+	{
+		const int k = b->k0 + l;
+		const float scale = (k == 0 || 2 * k == b->N) ? b->gain : 2.0f * b->gain;
+		b->amp[l] = scale * sqrtf(b->amp[l] > 0.0f ? b->amp[l] : 0.0f);
+	}
+}
+
+int goertzel_peak(const GoertzelBank *b)
+{
+	int best = -1;
+	for (int l = 0; l < b->nb; l++)
+		if (best < 0 || b->amp[l] > b->amp[best])
+			best = l;
+	return best;
+}
+
+// NOTE - Limites das bandas iguais aos de compute_bearing_issue_freq
+int bearing_bank_init(BearingBank *b, int N, float fs, int max_in,
+					  float motor_min_hz, float motor_max_hz,
+					  float low_freq_thresh_hz, float rel_amp_thresh)
+{
+	memset(b, 0, sizeof(*b));
+	if (N % BEARING_BANK_LF_DECIM || max_in <= 0)
+		return -1;
+	b->rel_th = rel_amp_thresh;
+
+	const int Nl = N / BEARING_BANK_LF_DECIM;
+	int lf_end = (int)ceilf(low_freq_thresh_hz * (float)N / fs);
+	if (lf_end > Nl / 2)
+		lf_end = Nl / 2;
+
+	// Banda do motor com os N pontos: os mesmos bins e limites que a referencia
+	const float bph = (float)N / fs;
+	int kmin = (int)ceilf(motor_min_hz * bph);
+	int kmax = (int)floorf(motor_max_hz * bph);
+	if (kmax > N / 2 - 1)
+		kmax = N / 2 - 1;
+
+	b->motor_k0 = kmin;
+	b->motor_k1 = kmax + 1;
+	b->motor_every = (int)ceilf(BEARING_MOTOR_PERIOD_MS * fs / 1000.0f);
+	if (kmin > kmax || goertzel_init(&b->lf, Nl, 0, lf_end) != 0 ||
+		!(b->motor_plan = fftfPlanCreate(N, NULL)) ||
+		decim_init(&b->decim, BEARING_BANK_LF_DECIM, DECIM_TAPS_PER_PHASE, DECIM_CUTOFF, max_in) != 0)
+	{
+		bearing_bank_destroy(b);
+		return -1;
+	}
+	b->lf_win = calloc(Nl, sizeof(float));
+	b->motor_win = aligned_alloc(32, sizeof(float) * ((N + 7) & ~7));
+	b->motor_xw = aligned_alloc(32, sizeof(float) * ((N + 7) & ~7));
+	b->motor_window = aligned_alloc(32, sizeof(float) * ((N + 7) & ~7));
+	b->motor_amp = aligned_alloc(32, sizeof(float) * ((N / 2 + 8) & ~7));
+	b->tmp = malloc(sizeof(float) * (max_in / BEARING_BANK_LF_DECIM + 1));
+	if (!b->lf_win || !b->motor_win || !b->motor_xw || !b->motor_window || !b->motor_amp || !b->tmp)
+	{
+		bearing_bank_destroy(b);
+		return -1;
+	}
+	memset(b->motor_win, 0, sizeof(float) * N);
+
+	// Mesma janela e normalizacao que o spectrum
+	double window_sum = 0.0;
+	for (int i = 0; i < N; i++)
+	{
+		b->motor_window[i] = (float)(0.5 * (1.0 - cos(2.0 * M_PI * i / (N - 1))));
+		window_sum += b->motor_window[i];
+	}
+	b->motor_gain = (float)(1.0 / window_sum);
+	return 0;
+}
+
+void bearing_bank_destroy(BearingBank *b)
+{
+	goertzel_destroy(&b->lf);
+	fftfPlanDestroy(b->motor_plan);
+	b->motor_plan = NULL;
+	decim_destroy(&b->decim);
+	free(b->lf_win);
+	free(b->motor_win);
+	free(b->motor_xw);
+	free(b->motor_window);
+	free(b->motor_amp);
+	free(b->tmp);
+	b->lf_win = b->motor_win = b->motor_xw = b->motor_window = b->motor_amp = b->tmp = NULL;
+}
+
+// Janela deslizante de len amostras: junta as n novas no fim
+static void window_push(float *w, int len, const float *y, int n)
+{
+	if (n > len)
+	{
+		y += n - len;
+		n = len;
+	}
+	memmove(w, w + n, sizeof(float) * (len - n));
+	memcpy(w + len - n, y, sizeof(float) * n);
+}
+
+int bearing_bank_update(BearingBank *b, const float *x, int n)
+{
+	// As janelas seguem o sinal mesmo quando nao ha decisao
+	const int N = b->motor_plan->N;
+	window_push(b->motor_win, N, x, n);
+	const int filling = b->motor_fill < N;
+	b->motor_fill = b->motor_fill + n < N ? b->motor_fill + n : N;
+	b->motor_since += n;
+	while (n > 0)
+	{
+		const int c = n < b->decim.max_in ? n : b->decim.max_in;
+		int nl = decim_process(&b->decim, x, c, b->tmp);
+		window_push(b->lf_win, b->lf.N, b->tmp, nl);
+		x += c;
+		n -= c;
+	}
+
+	// Banda do motor: espectro de N pontos e pico nos bins [k0, k1), ao
+	// ritmo da decisao (a cada bloco so enquanto a janela enche)
+	if (filling || b->motor_since >= b->motor_every)
+	{
+		for (int i = 0; i < N; i++)
+			b->motor_xw[i] = b->motor_win[i] * b->motor_window[i];
+		fftfRealExecute(b->motor_plan, b->motor_xw);
+		fftfAmplitude(b->motor_plan, b->motor_amp, b->motor_gain);
+		int km = b->motor_plan->k->peak(b->motor_amp, b->motor_k0, b->motor_k1);
+		b->motor_peak = km >= 0 ? b->motor_amp[km] : 0.0f;
+		b->motor_since = 0;
+	}
+	if (b->motor_peak <= 0.0f)
+		return 0; // sem referência assumimos normal
+
+	goertzel_compute(&b->lf, b->lf_win);
+	int kl = goertzel_peak(&b->lf);
+	b->lf_peak = kl >= 0 ? b->lf.amp[kl] : 0.0f;
+	return b->lf_peak > b->rel_th * b->motor_peak;
+}
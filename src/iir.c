@@ -0,0 +1,457 @@
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <complex.h>
+#include "iir.h"
+#include "config.h"
+
+static void biquad_set(IIRBiquad *q, double b0, double b1, double b2,
+					   double a0, double a1, double a2)
+{
+	q->b0 = (float)(b0 / a0);
+	q->b1 = (float)(b1 / a0);
+	q->b2 = (float)(b2 / a0);
+	q->a1 = (float)(a1 / a0);
+	q->a2 = (float)(a2 / a0);
+	q->s1 = q->s2 = 0.0f;
+}
+
+// NOTE - Butterworth passa-baixo
+// Polos analogicos aos pares com Q_k = 1 / (2 sin((2k+1) pi / (2 order)))
+// Cada par vira um biquad (formulas RBJ, com pre-distorcao da bilinear);
+// ordem impar acrescenta uma secao de 1a ordem
+int iir_design_butter_lp(IIRFilter *f, int order, double fc, double fs)
+{
+	if (order < 1 || order > 2 * IIR_MAX_SECTIONS || fc <= 0.0 || fc >= fs / 2.0)
+		return -1;
+
+	memset(f, 0, sizeof(*f));
+	const double w0 = 2.0 * M_PI * fc / fs;
+	const double cw = cos(w0), sw = sin(w0);
+
+	for (int k = 0; k < order / 2; k++)
+	{
+		double Q = 1.0 / (2.0 * sin((2 * k + 1) * M_PI / (2.0 * order)));
+		double alpha = sw / (2.0 * Q);
+		biquad_set(&f->sec[f->nsec++],
+				   (1.0 - cw) / 2.0, 1.0 - cw, (1.0 - cw) / 2.0,
+				   1.0 + alpha, -2.0 * cw, 1.0 - alpha);
+	}
+	if (order % 2)
+	{
+		double K = tan(w0 / 2.0);
+		biquad_set(&f->sec[f->nsec++], K, K, 0.0, K + 1.0, K - 1.0, 0.0);
+	}
+	return 0;
+}
+
+void iir_reset(IIRFilter *f)
+{
+	for (int s = 0; s < f->nsec; s++)
+		f->sec[s].s1 = f->sec[s].s2 = 0.0f;
+}
+
+#define IIR_INLINE static inline __attribute__((always_inline))
+
+// NOTE - Transposicao de 8x8 floats (r[l][j] -> r[j][l]) com shuffles
+typedef int iir_vi __attribute__((vector_size(IIR_VEC * sizeof(int))));
+typedef int16_t iir_vs __attribute__((vector_size(IIR_VEC * sizeof(int16_t))));
+
+IIR_INLINE void transpose8(iir_vf r[8])
+{
+	const iir_vi lo = {0, 8, 1, 9, 4, 12, 5, 13}, hi = {2, 10, 3, 11, 6, 14, 7, 15};
+	const iir_vi lo2 = {0, 1, 8, 9, 4, 5, 12, 13}, hi2 = {2, 3, 10, 11, 6, 7, 14, 15};
+	const iir_vi lo4 = {0, 1, 2, 3, 8, 9, 10, 11}, hi4 = {4, 5, 6, 7, 12, 13, 14, 15};
+	iir_vf t[8], u[8];
+	for (int p = 0; p < 8; p += 2)
+	{
+		t[p] = __builtin_shuffle(r[p], r[p + 1], lo);
+		t[p + 1] = __builtin_shuffle(r[p], r[p + 1], hi);
+	}
+	for (int p = 0; p < 8; p += 4)
+	{
+		u[p] = __builtin_shuffle(t[p], t[p + 2], lo2);
+		u[p + 1] = __builtin_shuffle(t[p], t[p + 2], hi2);
+		u[p + 2] = __builtin_shuffle(t[p + 1], t[p + 3], lo2);
+		u[p + 3] = __builtin_shuffle(t[p + 1], t[p + 3], hi2);
+	}
+	for (int p = 0; p < 4; p++)
+	{
+		r[p] = __builtin_shuffle(u[p], u[p + 4], lo4);
+		r[p + 4] = __builtin_shuffle(u[p], u[p + 4], hi4);
+	}
+}
+
+// NOTE - Bloco normal <-> bloco transposto (segmentos de m amostras)
+// Em quadrados de 8 segmentos x 8 amostras
+IIR_INLINE void load_block(iir_vf *w, const int16_t *in16, const float *inf, int m)
+{
+	for (int i0 = 0; i0 < m; i0 += 8)
+		for (int v = 0; v < IIR_NV; v++)
+		{
+			iir_vf r[8];
+			for (int l = 0; l < 8; l++)
+			{
+				const int off = (v * IIR_VEC + l) * m + i0;
+				if (in16)
+				{
+					iir_vs s;
+					memcpy(&s, in16 + off, sizeof(s));
+					r[l] = __builtin_convertvector(s, iir_vf);
+				}
+				else
+					memcpy(&r[l], inf + off, sizeof(r[l]));
+			}
+			transpose8(r);
+			for (int j = 0; j < 8; j++)
+				w[(i0 + j) * IIR_NV + v] = r[j];
+		}
+}
+
+IIR_INLINE void store_block(const iir_vf *w, float *out, int m)
+{
+	for (int i0 = 0; i0 < m; i0 += 8)
+		for (int v = 0; v < IIR_NV; v++)
+		{
+			iir_vf r[8];
+			for (int j = 0; j < 8; j++)
+				r[j] = w[(i0 + j) * IIR_NV + v];
+			transpose8(r);
+			for (int l = 0; l < 8; l++)
+				memcpy(out + (v * IIR_VEC + l) * m + i0, &r[l], sizeof(r[l]));
+		}
+}
+
+// NOTE - Caminho vetorial de um grupo sobre o bloco transposto
+// Segmento k = lane k % IIR_VEC do vetor k / IIR_VEC de cada linha.
+// nvi vetores de cada linha sao processados em conjunto (cadeias independentes
+// intercaladas): IIR_NV com AVX2 (16 registos de 8 floats), 1 no caminho
+// generico, onde cada vetor ocupa 2 registos SSE e nao ha registos para mais
+IIR_INLINE void group_body(iir_vf *w, int m, const IIRGroup *gr,
+						   IIRBiquad *qa, IIRBiquad *qb, const int nvi)
+{
+	const int D = qb ? 4 : 2;
+
+	// 1. Estado final de cada segmento com estado inicial zero
+	iir_vf g[4][IIR_NV];
+	for (int v0 = 0; v0 < IIR_NV; v0 += nvi)
+	{
+		iir_vf acc[4][IIR_NV] = {{{0}}};
+		if (qb)
+		{
+			for (int i = 0; i < m; i++)
+				for (int v = 0; v < nvi; v++)
+				{
+					iir_vf x = w[i * IIR_NV + v0 + v];
+					acc[0][v] += gr->g[0][i] * x;
+					acc[1][v] += gr->g[1][i] * x;
+					acc[2][v] += gr->g[2][i] * x;
+					acc[3][v] += gr->g[3][i] * x;
+				}
+		}
+		else
+		{
+			for (int i = 0; i < m; i++)
+				for (int v = 0; v < nvi; v++)
+				{
+					iir_vf x = w[i * IIR_NV + v0 + v];
+					acc[0][v] += gr->g[0][i] * x;
+					acc[1][v] += gr->g[1][i] * x;
+				}
+		}
+		for (int v = 0; v < nvi; v++)
+			for (int r = 0; r < D; r++)
+				g[r][v0 + v] = acc[r][v];
+	}
+
+	// 2. Estado inicial verdadeiro de cada segmento (cadeia curta, escalar)
+	float S[4] = {qa->s1, qa->s2, qb ? qb->s1 : 0.0f, qb ? qb->s2 : 0.0f};
+	iir_vf z[4][IIR_NV];
+	for (int k = 0; k < IIR_LANES; k++)
+	{
+		const int v = k / IIR_VEC, l = k % IIR_VEC;
+		float t[4];
+		for (int r = 0; r < D; r++)
+		{
+			z[r][v][l] = S[r];
+			t[r] = g[r][v][l];
+			for (int c = 0; c < D; c++)
+				t[r] += gr->Am[r][c] * S[c];
+		}
+		memcpy(S, t, sizeof(float) * D);
+	}
+
+	// 3. Recorrencia em todos os segmentos ao mesmo tempo
+	// (b1 x + s2) - a1 y: so um multiply-add depende de y na cadeia
+	const float b0 = qa->b0, b1 = qa->b1, b2 = qa->b2, a1 = qa->a1, a2 = qa->a2;
+	const float c0 = qb ? qb->b0 : 0.0f, c1 = qb ? qb->b1 : 0.0f, c2 = qb ? qb->b2 : 0.0f;
+	const float d1 = qb ? qb->a1 : 0.0f, d2 = qb ? qb->a2 : 0.0f;
+	for (int v0 = 0; v0 < IIR_NV; v0 += nvi)
+	{
+		iir_vf za1[IIR_NV], za2[IIR_NV], zb1[IIR_NV], zb2[IIR_NV];
+		for (int v = 0; v < nvi; v++)
+		{
+			za1[v] = z[0][v0 + v];
+			za2[v] = z[1][v0 + v];
+			zb1[v] = z[2][v0 + v];
+			zb2[v] = z[3][v0 + v];
+		}
+		if (qb)
+		{
+			for (int i = 0; i < m; i++)
+				for (int v = 0; v < nvi; v++)
+				{
+					iir_vf x = w[i * IIR_NV + v0 + v];
+					iir_vf y = b0 * x + za1[v];
+					za1[v] = (b1 * x + za2[v]) - a1 * y;
+					za2[v] = b2 * x - a2 * y;
+					iir_vf u = c0 * y + zb1[v];
+					zb1[v] = (c1 * y + zb2[v]) - d1 * u;
+					zb2[v] = c2 * y - d2 * u;
+					w[i * IIR_NV + v0 + v] = u;
+				}
+		}
+		else
+		{
+			for (int i = 0; i < m; i++)
+				for (int v = 0; v < nvi; v++)
+				{
+					iir_vf x = w[i * IIR_NV + v0 + v];
+					iir_vf y = b0 * x + za1[v];
+					za1[v] = (b1 * x + za2[v]) - a1 * y;
+					za2[v] = b2 * x - a2 * y;
+					w[i * IIR_NV + v0 + v] = y;
+				}
+		}
+		for (int v = 0; v < nvi; v++)
+		{
+			z[0][v0 + v] = za1[v];
+			z[1][v0 + v] = za2[v];
+			z[2][v0 + v] = zb1[v];
+			z[3][v0 + v] = zb2[v];
+		}
+	}
+
+	// O estado do ultimo segmento continua no bloco seguinte
+	qa->s1 = z[0][IIR_NV - 1][IIR_VEC - 1];
+	qa->s2 = z[1][IIR_NV - 1][IIR_VEC - 1];
+	if (qb)
+	{
+		qb->s1 = z[2][IIR_NV - 1][IIR_VEC - 1];
+		qb->s2 = z[3][IIR_NV - 1][IIR_VEC - 1];
+	}
+}
+
+IIR_INLINE void block_body(IIRFilter *f, const int16_t *in16, const float *inf, float *out,
+						   const int nvi)
+{
+	const int m = f->block_n / IIR_LANES;
+	load_block(f->work, in16, inf, m);
+	for (int k = 0; k < f->ngroups; k++)
+	{
+		const IIRGroup *gr = &f->grp[k];
+		group_body(f->work, m, gr, &f->sec[gr->first],
+				   gr->ns > 1 ? &f->sec[gr->first + 1] : NULL, nvi);
+	}
+	store_block(f->work, out, m);
+}
+
+static void run_block_generic(IIRFilter *f, const int16_t *in16, const float *inf, float *out)
+{
+	block_body(f, in16, inf, out, 1);
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+// Mesmo codigo compilado para AVX2+FMA (vetores de 8 floats num registo)
+__attribute__((target("avx2,fma"))) static void run_block_avx2(IIRFilter *f, const int16_t *in16,
+																const float *inf, float *out)
+{
+	block_body(f, in16, inf, out, IIR_NV);
+}
+#endif
+
+// NOTE - Preparacao do caminho vetorial
+// DF2T de uma secao: y = b0 x + s1, s1' = b1 x - a1 y + s2, s2' = b2 x - a2 y
+// => s' = A s + B x, y = s1 + D x com A = [-a1 1; -a2 0], B = [b1 - a1 b0; b2 - a2 b0], D = b0
+// Num par (a, b) a entrada de b e y_a, o que da o sistema de 4 estados
+//    A = [A_a 0; B_b C A_b], B = [B_a; B_b D_a], C = [1 0]
+// O estado final de um segmento de m amostras com estado inicial zero e
+// sum_i A^(m-1-i) B x[i]; os vetores A^j B sao calculados em double
+static int group_prepare(IIRFilter *f, IIRGroup *gr, int m)
+{
+	const int D = 2 * gr->ns;
+	double A[2 * IIR_GROUP][2 * IIR_GROUP] = {{0}}, B[2 * IIR_GROUP] = {0};
+
+	for (int j = 0; j < gr->ns; j++)
+	{
+		const IIRBiquad *q = &f->sec[gr->first + j];
+		const int o = 2 * j;
+		const double Bq0 = q->b1 - q->a1 * q->b0, Bq1 = q->b2 - q->a2 * q->b0;
+		A[o][o] = -q->a1;
+		A[o][o + 1] = 1.0;
+		A[o + 1][o] = -q->a2;
+		if (j == 0)
+		{
+			B[o] = Bq0;
+			B[o + 1] = Bq1;
+		}
+		else
+		{
+			// entrada da secao b: y_a = s1_a + b0_a x
+			const double Da = f->sec[gr->first + j - 1].b0;
+			A[o][o - 2] = Bq0;
+			A[o + 1][o - 2] = Bq1;
+			B[o] = Bq0 * Da;
+			B[o + 1] = Bq1 * Da;
+		}
+	}
+
+	for (int d = 0; d < D; d++)
+	{
+		gr->g[d] = malloc(sizeof(float) * m);
+		if (!gr->g[d])
+			return -1;
+	}
+
+	double v[2 * IIR_GROUP], M[2 * IIR_GROUP][2 * IIR_GROUP] = {{0}};
+	for (int d = 0; d < D; d++)
+	{
+		v[d] = B[d];
+		M[d][d] = 1.0;
+	}
+	for (int j = 0; j < m; j++)
+	{
+		for (int d = 0; d < D; d++)
+			gr->g[d][m - 1 - j] = (float)v[d];
+
+		// v = A v, M = A M
+		double t[2 * IIR_GROUP], T[2 * IIR_GROUP][2 * IIR_GROUP];
+		for (int r = 0; r < D; r++)
+		{
+			t[r] = 0.0;
+			for (int c = 0; c < D; c++)
+			{
+				t[r] += A[r][c] * v[c];
+				T[r][c] = 0.0;
+				for (int k = 0; k < D; k++)
+					T[r][c] += A[r][k] * M[k][c];
+			}
+		}
+		memcpy(v, t, sizeof(v));
+		memcpy(M, T, sizeof(M));
+	}
+	for (int r = 0; r < D; r++)
+		for (int c = 0; c < D; c++)
+			gr->Am[r][c] = (float)M[r][c];
+	return 0;
+}
+
+int iir_set_block(IIRFilter *f, int n)
+{
+	if (n <= 0 || n % (8 * IIR_LANES))
+		return -1;
+	const int m = n / IIR_LANES;
+
+	iir_destroy(f);
+	f->work = aligned_alloc(sizeof(iir_vf), sizeof(float) * n);
+	if (!f->work)
+		return -1;
+
+	f->ngroups = 0;
+	for (int s = 0; s < f->nsec; s += IIR_GROUP)
+	{
+		IIRGroup *gr = &f->grp[f->ngroups++];
+		gr->first = s;
+		gr->ns = f->nsec - s < IIR_GROUP ? f->nsec - s : IIR_GROUP;
+		if (group_prepare(f, gr, m) != 0)
+		{
+			iir_destroy(f);
+			return -1;
+		}
+	}
+
+	f->run_block = run_block_generic;
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+		f->run_block = run_block_avx2;
+#endif
+	f->block_n = n;
+	return 0;
+}
+
+void iir_destroy(IIRFilter *f)
+{
+	free(f->work);
+	f->work = NULL;
+	for (int k = 0; k < f->ngroups; k++)
+		for (int d = 0; d < 2 * IIR_GROUP; d++)
+		{
+			free(f->grp[k].g[d]);
+			f->grp[k].g[d] = NULL;
+		}
+	f->ngroups = 0;
+	f->block_n = 0;
+}
+
+// NOTE - Caminho escalar (blocos de tamanho nao preparado)
+static void process_scalar(IIRFilter *f, float *x, int n)
+{
+	for (int s = 0; s < f->nsec; s++)
+	{
+		IIRBiquad *q = &f->sec[s];
+		float s1 = q->s1, s2 = q->s2;
+		for (int i = 0; i < n; i++)
+		{
+			float y = q->b0 * x[i] + s1;
+			s1 = q->b1 * x[i] - q->a1 * y + s2;
+			s2 = q->b2 * x[i] - q->a2 * y;
+			x[i] = y;
+		}
+		q->s1 = s1;
+		q->s2 = s2;
+	}
+}
+
+void iir_process(IIRFilter *f, float *x, int n)
+{
+	if (n == f->block_n)
+		f->run_block(f, NULL, x, x);
+	else
+		process_scalar(f, x, n);
+}
+
+void iir_process_f32(IIRFilter *f, const float *in, float *out, int n)
+{
+	if (n == f->block_n)
+	{
+		f->run_block(f, NULL, in, out);
+		return;
+	}
+	memcpy(out, in, sizeof(float) * n);
+	process_scalar(f, out, n);
+}
+
+void iir_process_s16(IIRFilter *f, const int16_t *in, float *out, int n)
+{
+	if (n == f->block_n)
+	{
+		f->run_block(f, in, NULL, out);
+		return;
+	}
+	for (int i = 0; i < n; i++)
+		out[i] = (float)in[i];
+	process_scalar(f, out, n);
+}
+
+double iir_gain(const IIRFilter *f, double freq, double fs)
+{
+	complex double z1 = cexp(-I * 2.0 * M_PI * freq / fs); // z^-1
+	complex double h = 1.0;
+	for (int s = 0; s < f->nsec; s++)
+	{
+		const IIRBiquad *q = &f->sec[s];
+		h *= (q->b0 + q->b1 * z1 + q->b2 * z1 * z1) / (1.0 + q->a1 * z1 + q->a2 * z1 * z1);
+	}
+	return cabs(h);
+}
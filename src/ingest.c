@@ -0,0 +1,193 @@
+#include <math.h>
+#include <string.h>
+#include "ingest.h"
+#include "config.h"
+
+#define INGEST_VEC 8
+#define INGEST_INLINE static inline __attribute__((always_inline))
+
+typedef float ingest_vf __attribute__((vector_size(INGEST_VEC * sizeof(float))));
+typedef int32_t ingest_vi __attribute__((vector_size(INGEST_VEC * sizeof(int32_t))));
+typedef uint32_t ingest_vu __attribute__((vector_size(INGEST_VEC * sizeof(uint32_t))));
+typedef uint16_t ingest_vh __attribute__((vector_size(INGEST_VEC * sizeof(uint16_t))));
+typedef int16_t ingest_vs __attribute__((vector_size(INGEST_VEC * sizeof(int16_t))));
+
+// NOTE - Uma amostra (fim dos pedacos que nao enchem um vetor)
+INGEST_INLINE float load1(const uint8_t *p, IngestType t, int swap)
+{
+	if (t == INGEST_U16 || t == INGEST_S16)
+	{
+		uint16_t u;
+		memcpy(&u, p, sizeof(u));
+		if (swap)
+			u = __builtin_bswap16(u);
+		return t == INGEST_U16 ? (float)((int)u - 32768) : (float)(int16_t)u;
+	}
+	uint32_t u;
+	memcpy(&u, p, sizeof(u));
+	if (swap)
+		u = __builtin_bswap32(u);
+	if (t == INGEST_S32)
+		return (float)(int32_t)u * (1.0f / 65536.0f);
+	float x;
+	memcpy(&x, &u, sizeof(x));
+	return x * 32768.0f;
+}
+
+// NOTE - 8 amostras do canal: leitura (contigua no mono, com passo de uma
+// trama nos intercalados), troca de bytes e conversao com vetores
+INGEST_INLINE void load8(ingest_vf *x, const uint8_t *p, long step, IngestType t, int swap, int contig)
+{
+	if (t == INGEST_U16 || t == INGEST_S16)
+	{
+		ingest_vh h;
+		if (contig)
+			memcpy(&h, p, sizeof(h));
+		else
+			for (int l = 0; l < INGEST_VEC; l++)
+			{
+				uint16_t u;
+				memcpy(&u, p + l * step, sizeof(u));
+				h[l] = u;
+			}
+		if (swap)
+			h = (h << 8) | (h >> 8);
+		if (t == INGEST_S16)
+			*x = __builtin_convertvector((ingest_vs)h, ingest_vf);
+		else
+			*x = __builtin_convertvector(__builtin_convertvector(h, ingest_vi) - 32768, ingest_vf);
+		return;
+	}
+
+	ingest_vu u;
+	if (contig)
+		memcpy(&u, p, sizeof(u));
+	else
+		for (int l = 0; l < INGEST_VEC; l++)
+		{
+			uint32_t w;
+			memcpy(&w, p + l * step, sizeof(w));
+			u[l] = w;
+		}
+	if (swap)
+		u = (u >> 24) | ((u >> 8) & 0xff00) | ((u << 8) & 0xff0000) | (u << 24);
+	if (t == INGEST_S32)
+		*x = __builtin_convertvector((ingest_vi)u, ingest_vf) * (1.0f / 65536.0f);
+	else
+		*x = (ingest_vf)u * 32768.0f;
+}
+
+// NOTE - Passagem unica: converte, tira o DC e soma
+// Duas somas parciais independentes (a soma nao espera pela anterior)
+INGEST_INLINE float run_body(const uint8_t *p, long step, float *dst, int n, float dc,
+							 IngestType t, int swap, int contig)
+{
+	ingest_vf s0 = {0}, s1 = {0};
+	int i = 0;
+	for (; i + 2 * INGEST_VEC <= n; i += 2 * INGEST_VEC)
+	{
+		ingest_vf x0, x1;
+		load8(&x0, p + i * step, step, t, swap, contig);
+		load8(&x1, p + (i + INGEST_VEC) * step, step, t, swap, contig);
+		s0 += x0;
+		s1 += x1;
+		x0 -= dc;
+		x1 -= dc;
+		memcpy(dst + i, &x0, sizeof(x0));
+		memcpy(dst + i + INGEST_VEC, &x1, sizeof(x1));
+	}
+	s0 += s1;
+	float sum = 0.0f;
+	for (int l = 0; l < INGEST_VEC; l++)
+		sum += s0[l];
+	for (; i < n; i++)
+	{
+		float x = load1(p + i * step, t, swap);
+		sum += x;
+		dst[i] = x - dc;
+	}
+	return sum;
+}
+
+// Uma versao de run_body por formato, troca de bytes e canais (constantes)
+#define INGEST_CASE(t, sw, ct) \
+	case (t) * 4 + (sw) * 2 + (ct): \
+		return run_body(p, step, dst, n, dc, t, sw, ct);
+#define INGEST_CASES(t) \
+	INGEST_CASE(t, 0, 0) INGEST_CASE(t, 0, 1) INGEST_CASE(t, 1, 0) INGEST_CASE(t, 1, 1)
+
+INGEST_INLINE float run_any(const IngestFormat *f, const uint8_t *frames, int k, float *dst, int n, float dc)
+{
+	const uint8_t *p = frames + k * f->sample_bytes;
+	const long step = f->frame_bytes;
+	const int swap = f->big_endian != INGEST_HOST_BE;
+	const int contig = f->channels == 1;
+	switch (f->type * 4 + swap * 2 + contig)
+	{
+		INGEST_CASES(INGEST_U16)
+		INGEST_CASES(INGEST_S16)
+		INGEST_CASES(INGEST_S32)
+		INGEST_CASES(INGEST_F32)
+	}
+	return 0.0f;
+}
+
+static float run_generic(const IngestFormat *f, const uint8_t *frames, int k, float *dst, int n, float dc)
+{
+	return run_any(f, frames, k, dst, n, dc);
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+// Mesmo codigo compilado para AVX2 (vetores de 8 floats num registo)
+__attribute__((target("avx2,fma"))) static float run_avx2(const IngestFormat *f, const uint8_t *frames,
+														   int k, float *dst, int n, float dc)
+{
+	return run_any(f, frames, k, dst, n, dc);
+}
+#endif
+
+int ingest_format_init(IngestFormat *f, IngestType type, int big_endian, int channels)
+{
+	if (type < INGEST_U16 || type > INGEST_F32 || channels < 1)
+		return -1;
+	f->type = type;
+	f->big_endian = big_endian != 0;
+	f->channels = channels;
+	f->sample_bytes = type == INGEST_U16 || type == INGEST_S16 ? 2 : 4;
+	f->frame_bytes = f->sample_bytes * channels;
+
+	f->run = run_generic;
+	f->kernel = "generic";
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+	{
+		f->run = run_avx2;
+		f->kernel = "avx2";
+	}
+#endif
+	return 0;
+}
+
+const char *ingest_format_name(const IngestFormat *f)
+{
+	static const char *names[4][2] = {
+		{"U16LE", "U16BE"}, {"S16LE", "S16BE"}, {"S32LE", "S32BE"}, {"F32LE", "F32BE"}};
+	return names[f->type][f->big_endian];
+}
+
+void ingest_dc_update(IngestDC *d, const IngestSrc *s, float fs)
+{
+	if (s->n == 0)
+		return;
+	const float mean = (float)(s->sum / s->n);
+	if (!d->primed)
+	{
+		d->dc = mean;
+		d->primed = 1;
+		return;
+	}
+	// Peso do pedaco pela sua duracao: o mesmo DC com pedacos de qualquer tamanho
+	const float a = 1.0f - expf(-(float)s->n * 1000.0f / (INGEST_DC_TAU_MS * fs));
+	d->dc += a * (mean - d->dc);
+}
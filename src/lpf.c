@@ -1,9 +1,9 @@
 #include <math.h>
 #include "lpf.h"
-#include "fft.h"
 #include "config.h"
+#include "fftf.h"
+#include "peak.h"
 #include <stdio.h>
-#include <complex.h>
 
 /* **************************************************************
  * Audio processing example:
@@ -25,6 +25,8 @@ float clampf(float v, float min, float max)
 
 // Funcao do filtro passa baixo alterada
 // Agora recebe valores com sinal
+// NOTE - O dispatcher usa agora o filtro IIR com estado (iir.h);
+// este fica como referencia para o bench_stages
 void filterLP(uint32_t cof, uint32_t sampleFreq, uint8_t *buffer, uint32_t nSamples)
 {
 
@@ -54,79 +56,64 @@ void filterLP(uint32_t cof, uint32_t sampleFreq, uint8_t *buffer, uint32_t nSamp
 	return;
 }
 
-// NOTE - FFT cálculo da frequência dominante para o speed
-float compute_dominant_freq(double complex *X, int N, int fs)
+// NOTE - Frequência dominante para o speed
+// Lê os bins do espectro calculado pelo dispatcher (bins 0..N/2)
+// e interpola a posicao do pico (SPEED_PEAK_METHOD)
+// A procura do pico usa o kernel SIMD escolhido no arranque
+float compute_dominant_freq(const Spectrum *s)
 {
-    fftCompute(X, N);
-
-    float freqs[N / 2];
-    float amps[N / 2];
-    fftGetAmplitude(X, N, fs, freqs, amps);
+    const float *amps = s->amp;
 
 	// REVIEW - comentar 
 	// O lpf reduz a aplitude das frequencias altas
 	// Mas a freq dominante continua a ser 3 kHz
 	// === DEBUG: verificar amplitude em torno dos 3 kHz ===
 	
-	//int k = (int)roundf(3000.0f * N / (float)fs);  // índice que corresponde a 3 kHz
+	//int k = (int)roundf(3000.0f * s->N / (float)s->fs);  // índice que corresponde a 3 kHz
 	//printf("[DEBUG] mag@3kHz = %.3f\n", amps[k]);
 
+    // So bins com f < MAX_USEFUL_FREQ (o bin de fs/2 fica de fora)
+    int end = (int)ceilf((float)MAX_USEFUL_FREQ * s->N / s->fs);
+    if (end > s->nbins - 1)
+        end = s->nbins - 1;
 
-    float f_peak = 0.0f;
-    float A_peak = 0.0f;
-
-    for (int i = 0; i < N / 2; i++)
-    {
-        if (amps[i] > A_peak && freqs[i] < MAX_USEFUL_FREQ)
-        {
-            A_peak = amps[i];
-            f_peak = freqs[i];
-        }
-    }
+    int i = fftfBestKernels()->peak(amps, 0, end);
+    if (i < 0 || amps[i] <= 0.0f)
+        return 0.0f;
 
-    return f_peak;
+    // NOTE - Posicao do pico entre bins (peak.h), opcionalmente com zoom
+    float kf = peak_interp(amps, s->re, s->im, s->N, i, SPEED_PEAK_METHOD);
+    if (SPEED_ZOOM > 0)
+        kf = peak_zoom(s->xw, s->N, kf, SPEED_ZOOM);
+    return kf * s->fs / (float)s->N;
 }
 
-int compute_bearing_issue_freq(const int16_t *x, int N, int fs,
+int compute_bearing_issue_freq(const Spectrum *s,
                              float motor_min_hz, float motor_max_hz,
                              float low_freq_thresh_hz,
                              float rel_amp_thresh)
 {
-    // Copia samples para vetor complexo 
-    static double complex Xbuf[ABUFSIZE_SAMPLES];
-    for (int i = 0; i < N; ++i) Xbuf[i] = (double)x[i];
-
-    // janela simples para reduzir leakage
-    for (int i = 0; i < N; ++i) {
-        double w = 0.5 * (1.0 - cos(2.0*M_PI*i/(N-1))); // Hann
-        Xbuf[i] *= w;
-    }
-
-    // FFT e espectro de amplitudes
-    fftCompute(Xbuf, N);
-
-    float fk[N/2];
-    float Ak[N/2];
-    fftGetAmplitude(Xbuf, N, fs, fk, Ak);
+    // Espectro com janela Hann calculado uma vez pelo dispatcher
+    const float *Ak = s->amp;
+    const int N = s->N;
+    const float bins_per_hz = (float)N / s->fs;
+    const FFTFKernels *kern = fftfBestKernels();
 
     // Amplitude máxima na banda do motor
-    float Amax_motor = 0.0f;
-    for (int k = 0; k < N/2; ++k) {
-        if (fk[k] >= motor_min_hz && fk[k] <= motor_max_hz) {
-            if (Ak[k] > Amax_motor) Amax_motor = Ak[k];
-        }
-    }
+    int kmin = (int)ceilf(motor_min_hz * bins_per_hz);
+    int kmax = (int)floorf(motor_max_hz * bins_per_hz);
+    if (kmax > N/2 - 1) kmax = N/2 - 1;
+    int km = kern->peak(Ak, kmin, kmax + 1);
+    float Amax_motor = (km >= 0) ? Ak[km] : 0.0f;
     if (Amax_motor <= 0.0f) return 0; // sem referência assumimos normal
 
-    // Procura picos anómalos em low freqs
-    for (int k = 0; k < N/2; ++k) {
-        if (fk[k] < low_freq_thresh_hz) {
-            if (Ak[k] > rel_amp_thresh * Amax_motor) {
-                // fault-like
-				return 1;
-            }
-        }
+    // Procura picos anómalos em low freqs (f < low_freq_thresh_hz)
+    int lf_end = (int)ceilf(low_freq_thresh_hz * bins_per_hz);
+    if (lf_end > N/2) lf_end = N/2;
+    int kl = kern->peak(Ak, 0, lf_end);
+    if (kl >= 0 && Ak[kl] > rel_amp_thresh * Amax_motor) {
+        // fault-like
+        return 1;
     }
     return 0;
 }
-
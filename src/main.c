@@ -2,21 +2,27 @@
 #include <stdlib.h>
 #include <errno.h>
 #include <string.h>
+#include <unistd.h>
 #include <SDL.h>
 #include <pthread.h>
 #include <sched.h>
+#include <signal.h>
 #include "config.h"
 #include "rtdb.h"
+#include "rtdb_shm.h"
 #include "buffer.h"
 #include "audio_io.h"
+#include "audio_source.h"
 #include "dispatcher.h"
 #include "speed.h"
 #include "display.h"
 #include "bearing.h"
-
-// globais definidas em audio_io.c
-extern AudioBuf bufA, bufB;
-extern AudioBuf *curBuf;
+#include "rt_stats.h"
+#include "channel.h"
+#include "runtime.h"
+#include "rtlog.h"
+#include "telemetry.h"
+#include "rawrec.h"
 
 static void set_thread_prio(pthread_t th, int prio)
 {
@@ -27,133 +33,348 @@ static void set_thread_prio(pthread_t th, int prio)
         perror("pthread_setschedparam");
 }
 
-int main(int argc, char **argv)
+// SIGUSR1: pede ao display um snapshot das estatisticas temporais
+static void on_sigusr1(int sig)
 {
-    if (SDL_Init(SDL_INIT_AUDIO) < 0)
-    {
-        printf("SDL init failed: %s\n", SDL_GetError());
-        return 1;
-    }
+    (void)sig;
+    rt_stats_dump_request = 1;
+}
 
-    RTDB db;
-    rtdb_init(&db);
-    buffer_init(&bufA);
-    buffer_init(&bufB);
-    curBuf = &bufA;
+static void usage(const char *prog)
+{
+    printf("Usage: %s [options] [device index]\n"
+           "       %s [options] [-d index]... [-C channels]\n"
+           "       %s [options] -f file.wav [-r] [-F]\n"
+           "       %s [options] -s key=value,...\n"
+           "  Sources can be combined; their channels are numbered in order (max %d)\n"
+           "  -p  periodic thread activation (default: event-driven)\n"
+           "  -n  stop after this many blocks per channel (default: 50 live, whole file)\n"
+           "  -w  runtime worker threads, max %d (default: one per core, up to the\n"
+           "      channels; extra workers only run stolen analysis tasks)\n"
+           "  -a  cpus for the workers, e.g. 2,3,4 (default: process affinity mask)\n"
+           "  -L  minimum log level: debug, info, warn, error (default: debug)\n"
+           "  -T  record per-block telemetry to this file (read with telem_csv)\n"
+           "  -R  keep the last %d ms of raw audio and write it to a WAV in this\n"
+           "      directory when a bearing fault starts (plus %d ms after it)\n"
+           "  -m  shared-memory name of the exported RTDB (default: %s, \"\" = off)\n"
+           "  -d  open this capture device (repeat for several devices)\n"
+           "  -C  channels per capture device (default: %d)\n"
+           "  -f  replay a WAV file (16/32-bit PCM or 32-bit float) instead of a capture device\n"
+           "  -r  the file is raw S16LE mono at %d Hz\n"
+           "  -F  replay as fast as the consumers can go (default: real time)\n"
+           "  -s  synthetic motor signal, keys (defaults in brackets):\n"
+           "        f0=Hz [300] f1=Hz ramp=s   fundamental, linear ramp f0->f1\n"
+           "        harm=n [4] amp= [6000] decay= [0.5]   harmonics\n"
+           "        fault=Hz [0] famp= [0.5] fstart=s [0]  bearing fault tone\n"
+           "        noise= [100] ch=n [1] dur=s [10] x=rate [1, 0 = fast]\n",
+           prog, prog, prog, prog, MAX_CHANNELS, RUNTIME_MAX_WORKERS, RAWREC_PRE_MS, RAWREC_POST_MS, RTDB_SHM_NAME, MONO, SAMP_FREQ);
+}
 
-    // Listar dispositivos de captura e pedir índice (compatível com original)
-    int ndev = SDL_GetNumAudioDevices(SDL_TRUE);
-    if (ndev < 1)
-    {
-        printf("No capture devices: %s\n", SDL_GetError());
-        return 1;
-    }
-    for (int i = 0; i < ndev; ++i)
+// Junta uma fonte aberta; os canais dela seguem-se aos das anteriores
+static int add_source(AudioSource *src, AudioSource **srcs, int *nsrcs, int *nch)
+{
+    if (!src)
+        return -1;
+    srcs[(*nsrcs)++] = src;
+    *nch += src->channels;
+    return 0;
+}
+
+// Lista de cpus "a,b,c"; retorna o n lido ou -1 se invalida
+static int parse_cpus(const char *s, int *cpus, int max)
+{
+    int n = 0;
+    while (*s)
     {
-        printf("%d - %s\n", i, SDL_GetAudioDeviceName(i, SDL_TRUE));
+        char *end;
+        long v = strtol(s, &end, 10);
+        if (end == s || v < 0 || n >= max)
+            return -1;
+        cpus[n++] = (int)v;
+        s = (*end == ',') ? end + 1 : end;
+        if (*end && *end != ',')
+            return -1;
     }
-    int index = 0;
-    if (argc >= 2)
-        index = atoi(argv[1]);
-    else
+    return n;
+}
+
+// Nivel de log pelo nome; -1 se invalido
+static int parse_level(const char *s)
+{
+    static const char *names[RTLOG_LEVELS] = {"debug", "info", "warn", "error"};
+    for (int l = 0; l < RTLOG_LEVELS; l++)
+        if (strcmp(s, names[l]) == 0)
+            return l;
+    return -1;
+}
+
+int main(int argc, char **argv)
+{
+    // Opcoes: ver usage(); argumento seguinte = indice do dispositivo
+    const char *file = NULL;
+    int raw = 0;
+    int pace = SOURCE_PACE_REALTIME;
+    int max_blocks = -1;
+    int synth = 0;
+    SynthParams sp;
+    synth_params_default(&sp);
+    int nworkers = DISPATCH_WORKERS;
+    int cpus[MAX_CHANNELS], ncpus = 0;
+    int devs[MAX_CHANNELS], ndevs = 0;
+    int dev_channels = MONO;
+    const char *shm_name = RTDB_SHM_NAME;
+    const char *telem_path = NULL;
+    const char *rec_dir = NULL;
+    int opt;
+    while ((opt = getopt(argc, argv, "pn:w:a:L:T:R:m:d:C:f:rFs:")) != -1)
     {
-        printf("Choose audio index: ");
-        fflush(stdout);
-        if (scanf("%d", &index) != 1)
+        switch (opt)
         {
-            puts("Invalid input");
+        case 'm':
+            shm_name = optarg;
+            break;
+        case 'T':
+            telem_path = optarg;
+            break;
+        case 'R':
+            rec_dir = optarg;
+            break;
+        case 'L':
+            rtlog_level = parse_level(optarg);
+            if (rtlog_level < 0)
+            {
+                printf("Invalid log level: %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 'w':
+            nworkers = atoi(optarg);
+            break;
+        case 'a':
+            ncpus = parse_cpus(optarg, cpus, MAX_CHANNELS);
+            if (ncpus < 1)
+            {
+                printf("Invalid cpu list: %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 'd':
+            if (ndevs == MAX_CHANNELS)
+            {
+                printf("Too many devices\n");
+                return 1;
+            }
+            devs[ndevs++] = atoi(optarg);
+            break;
+        case 'C':
+            dev_channels = atoi(optarg);
+            break;
+        case 'p':
+            periodic_mode = 1;
+            break;
+        case 'n':
+            max_blocks = atoi(optarg);
+            break;
+        case 'f':
+            file = optarg;
+            break;
+        case 'r':
+            raw = 1;
+            break;
+        case 'F':
+            pace = SOURCE_PACE_FAST;
+            break;
+        case 's':
+            synth = 1;
+            if (synth_params_parse(&sp, optarg) != 0)
+            {
+                printf("Invalid synthetic source spec: %s\n", optarg);
+                usage(argv[0]);
+                return 1;
+            }
+            break;
+        default:
+            usage(argv[0]);
             return 1;
         }
     }
-    if (index < 0 || index >= ndev)
-    {
-        printf("Invalid device ID. Must be 0..%d\n", ndev - 1);
+    printf("Thread activation: %s\n", periodic_mode ? "periodic" : "event-driven");
+    signal(SIGUSR1, on_sigusr1);
+
+    // NOTE - Fontes de audio: sintetica, ficheiro e/ou dispositivos de captura SDL
+    // Cada fonte ocupa os canais seguintes aos da anterior
+    AudioSource *srcs[MAX_CHANNELS];
+    int nsrcs = 0, nch = 0;
+    if (!synth && !file && ndevs == 0)
+        devs[ndevs++] = optind < argc ? atoi(argv[optind]) : -1;
+    if (synth && add_source(audio_source_synth_open(&sp, nch), srcs, &nsrcs, &nch) != 0)
         return 1;
+    if (file && add_source(audio_source_file_open(file, raw, pace, nch), srcs, &nsrcs, &nch) != 0)
+        return 1;
+    for (int i = 0; i < ndevs; i++)
+        if (add_source(audio_source_sdl_open(devs[i], dev_channels, nch), srcs, &nsrcs, &nch) != 0)
+            return 1;
+
+    // Critério de paragem por omissao: 50 blocos ao vivo, o ficheiro todo em replay
+    if (max_blocks < 0)
+        max_blocks = ndevs == 0 ? 0 : 50;
+
+    // NOTE - Contexto de cada canal (pool, filtros, filas) e slots da RTDB
+    // A RTDB fica em memoria partilhada para outros processos (rtdb_shm.h);
+    // sem o segmento corre com uma RTDB local
+    static RTDB local_db;
+    RTDB *db = NULL;
+    if (*shm_name)
+    {
+        db = rtdb_shm_create(shm_name, nch);
+        if (db)
+            printf("[RTDB] exported as %s (%zu bytes)\n", shm_name, sizeof(RtdbShm));
+        else if (errno == EBUSY)
+            printf("[RTDB] cannot export as %s: in use by pid %d (choose another name with -m)\n",
+                   shm_name, (int)rtdb_shm_owner(shm_name));
+        else
+            printf("[RTDB] cannot export as %s: %s\n", shm_name, strerror(errno));
     }
-    printf("Using audio capture device %d - %s\n", index, SDL_GetAudioDeviceName(index, SDL_TRUE));
-
-    // Abrir device de gravação
-    SDL_AudioSpec desired;
-    SDL_zero(desired);
-    desired.freq = SAMP_FREQ;
-    desired.format = FORMAT;
-    desired.channels = MONO;
-    desired.samples = ABUFSIZE_SAMPLES;
-    desired.callback = audio_recording_callback;
-
-    SDL_AudioSpec obtained;
-    SDL_AudioDeviceID rec = SDL_OpenAudioDevice(SDL_GetAudioDeviceName(index, SDL_TRUE), SDL_TRUE,
-                                                &desired, &obtained, SDL_AUDIO_ALLOW_FORMAT_CHANGE);
-
-    if (!rec)
+    if (!db)
     {
-        printf("Open capture failed: %s\n", SDL_GetError());
-        return 1;
+        db = &local_db;
+        rtdb_init(db, nch);
     }
-    gRecDev = rec;
-
-    // threads
-    if (pthread_create(&dispatcher_th, NULL, dispatcher_loop, NULL) != 0)
+    // A gravacao das falhas retem blocos: pools maiores
+    int pool_slots = AUDIO_POOL_SLOTS + (rec_dir ? rawrec_extra_slots() : 0);
+    if (channels_init(nch, pool_slots) != 0)
     {
-        perror("dispatcher");
+        printf("Channel init failed (%d channels)\n", nch);
         return 1;
     }
 
-    speed_set_rtdb(&db);
-    if (pthread_create(&speed_th, NULL, speed_loop, NULL) != 0)
+    // NOTE - Log das threads RT: escrito por uma thread SCHED_OTHER
+    if (rtlog_start(stdout, NULL) != 0)
+        return 1;
+
+    // NOTE - Telemetria por bloco: escrita por uma thread SCHED_OTHER
+    if (telem_path && telemetry_start(telem_path, nch) != 0)
+        return 1;
+
+    // NOTE - Audio a volta das falhas: escrito por uma thread SCHED_OTHER
+    if (rec_dir && rawrec_start(rec_dir, db, nch) != 0)
+        return 1;
+
+    // NOTE - Analises: tarefas do runtime, uma fila por analise em cada canal
+    int speed_q = speed_register(db);
+    int bearing_q = bearing_register(db);
+    if (speed_q < 0 || bearing_q < 0)
+        return 1;
+    if (dispatcher_init() != 0)
     {
-        perror("speed");
+        printf("Dispatcher init failed\n");
         return 1;
     }
 
-    bearing_set_rtdb(&db);
-    if (pthread_create(&bearing_th, NULL, bearing_loop, NULL) != 0)
+    // workers do runtime e distribuicao dos canais
+    if (runtime_init(nworkers, ncpus ? cpus : NULL, ncpus) != 0)
     {
-        perror("bearing");
+        printf("Runtime init failed\n");
         return 1;
     }
 
-    display_set_rtdb(&db);
+    // threads - prioridades RT entre 1 e 99: os workers ficam com a do
+    // antigo speed, o display abaixo deles
+    if (runtime_start(60) != 0)
+        return 1;
+
+    display_set_rtdb(db);
     if (pthread_create(&display_th, NULL, display_loop, NULL) != 0)
     {
         perror("display");
         return 1;
     }
-
-    // Prioridades RT - entre 1 e 99
-    set_thread_prio(speed_th, 60);
-    set_thread_prio(bearing_th, 50);
     set_thread_prio(display_th, 40);
 
     // Iniciar gravacao
-    SDL_PauseAudioDevice(rec, SDL_FALSE);
+    for (int i = 0; i < nsrcs; i++)
+        if (srcs[i]->start(srcs[i]) != 0)
+            return 1;
 
-    // Critério de paragem - parar quando blocksdispatched >= 50
+    // Critério de paragem - parar quando todos os canais tem max_blocks blocos
+    // ou quando as fontes chegam ao fim (max_blocks == 0: sem limite)
     while (1)
     {
-        SDL_LockAudioDevice(rec);
-        if (dispatcher_blocks_count() >= 50)
+        int finished = 1;
+        for (int i = 0; i < nsrcs; i++)
+            finished &= srcs[i]->finished(srcs[i]);
+        if ((max_blocks > 0 && dispatcher_blocks_count() >= max_blocks) || finished)
         {
-            SDL_PauseAudioDevice(rec, SDL_TRUE);
-            SDL_UnlockAudioDevice(rec);
+            for (int i = 0; i < nsrcs; i++)
+                srcs[i]->stop(srcs[i]);
             break;
         }
-        SDL_UnlockAudioDevice(rec);
+
+        // Snapshot das estatisticas temporais pedido em runtime (kill -USR1)
+        if (rt_stats_dump_request)
+        {
+            rt_stats_dump_request = 0;
+            rt_stats_print(stdout);
+        }
+        SDL_Delay(5);
+    }
+
+    // Deixar os consumidores processar os blocos que ja foram capturados
+    for (int i = 0; i < 400; i++)
+    {
+        int idle = 1;
+        for (int c = 0; c < nch; c++)
+        {
+            BufferPoolStats ps;
+            buffer_pool_stats(&gChannels[c].pool, &ps);
+            idle &= ps.nfree + rawrec_held(c) == ps.nslots;
+        }
+        if (idle)
+            break;
         SDL_Delay(5);
     }
 
     // parar threads e fechar
-    dispatcher_run = 0;
-    speed_run = 0;
-    bearing_run = 0;
+    runtime_run = 0;
     display_run = 0;
 
-    pthread_join(speed_th, NULL);
-    pthread_join(bearing_th, NULL);
     pthread_join(display_th, NULL);
-    pthread_join(dispatcher_th, NULL);
+    runtime_join();
+    rtlog_stop();
+    telemetry_stop();
+    rawrec_stop();
+
+    unsigned long speed_drops = 0, bearing_drops = 0;
+    BufferPoolStats tot = {0};
+    for (int c = 0; c < nch; c++)
+    {
+        speed_drops += desc_queue_dropped(&gChannels[c].q[speed_q]);
+        bearing_drops += desc_queue_dropped(&gChannels[c].q[bearing_q]);
+
+        BufferPoolStats ps;
+        buffer_pool_stats(&gChannels[c].pool, &ps);
+        tot.nslots += ps.nslots;
+        tot.nfree += ps.nfree;
+        tot.free_lowwater = c == 0 || ps.free_lowwater < tot.free_lowwater ? ps.free_lowwater : tot.free_lowwater;
+        tot.captured += ps.captured;
+        tot.capture_drops += ps.capture_drops;
+    }
+    printf("[DISPATCH] channels=%d blocks=%d dropped: speed=%lu bearing=%lu\n",
+           nch, dispatcher_blocks_total(), speed_drops, bearing_drops);
+    // Somas de todos os canais; low-water e o minimo de um canal
+    printf("[POOL] slots=%d free=%d low-water=%d captured=%lu capture drops=%lu\n",
+           tot.nslots, tot.nfree, tot.free_lowwater, tot.captured, tot.capture_drops);
+    truth_print_summary();
+    rt_stats_print(stdout);
+    runtime_print_stats(stdout);
+    speed_print_stats(stdout);
 
-    SDL_CloseAudioDevice(rec);
-    SDL_Quit();
+    for (int i = 0; i < nsrcs; i++)
+        srcs[i]->close(srcs[i]);
+    if (ndevs > 0)
+        SDL_Quit();
+    channels_destroy();
+    if (db != &local_db)
+        rtdb_shm_destroy(shm_name, db);
     return 0;
 }
@@ -0,0 +1,50 @@
+#include <errno.h>
+#include <limits.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include "notify.h"
+
+static long futex(atomic_uint *addr, int op, unsigned val, const struct timespec *ts)
+{
+    return syscall(SYS_futex, (unsigned *)addr, op, val, ts, NULL, 0);
+}
+
+void notifier_init(Notifier *n)
+{
+    atomic_init(&n->seq, 0);
+    atomic_init(&n->waiters, 0);
+}
+
+unsigned notifier_seq(Notifier *n)
+{
+    return atomic_load_explicit(&n->seq, memory_order_acquire);
+}
+
+void notifier_signal(Notifier *n)
+{
+    // seq_cst nos dois lados: ou quem sinaliza ve o waiter,
+    // ou o futex_wait do waiter ve o seq novo
+    atomic_fetch_add(&n->seq, 1);
+    if (atomic_load(&n->waiters) > 0)
+        futex(&n->seq, FUTEX_WAKE_PRIVATE, INT_MAX, NULL);
+}
+
+int notifier_wait(Notifier *n, unsigned seen, long timeout_ms)
+{
+    struct timespec ts = {
+        .tv_sec = timeout_ms / 1000,
+        .tv_nsec = (timeout_ms % 1000) * 1000000L,
+    };
+
+    atomic_fetch_add(&n->waiters, 1);
+    // O kernel so adormece se seq ainda for igual a seen
+    long r = futex(&n->seq, FUTEX_WAIT_PRIVATE, seen, &ts);
+    int err = errno;
+    atomic_fetch_sub(&n->waiters, 1);
+
+    if (r == -1 && err == ETIMEDOUT)
+        return 0;
+    return 1;
+}
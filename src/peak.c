@@ -0,0 +1,101 @@
+#include <math.h>
+#include <complex.h>
+#include "peak.h"
+#include "config.h"
+
+// DTFT do bloco nas frequencias k - d, k, k + d (em bins, fracionarias). Fasores atualizados por rotacao em double (N <= alguns
+// milhares); as contas sao escritas em real para evitar a multiplicacao
+// complexa C99 (__muldc3) e as tres rotacoes correm em paralelo
+static void dtft3(const float *x, int N, double k, double d, complex double X[3])
+{
+	double wr[3], wi[3], pr[3] = {1.0, 1.0, 1.0}, pi[3] = {0}, ar[3] = {0}, ai[3] = {0};
+	for (int j = 0; j < 3; j++)
+	{
+		wr[j] = cos(2.0 * M_PI * (k + (j - 1) * d) / N);
+		wi[j] = -sin(2.0 * M_PI * (k + (j - 1) * d) / N);
+	}
+	for (int n = 0; n < N; n++)
+		for (int j = 0; j < 3; j++)
+		{
+			ar[j] += x[n] * pr[j];
+			ai[j] += x[n] * pi[j];
+			const double t = pr[j] * wr[j] - pi[j] * wi[j];
+			pi[j] = pr[j] * wi[j] + pi[j] * wr[j];
+			pr[j] = t;
+		}
+	for (int j = 0; j < 3; j++)
+		X[j] = ar[j] + I * ai[j];
+}
+
+float peak_parabola(double a, double b, double c)
+{
+	double den = a - 2.0 * b + c;
+	if (den >= 0.0)
+		return 0.0f; // nao e um maximo
+	double d = 0.5 * (a - c) / den;
+	return (float)(d > 0.5 ? 0.5 : d < -0.5 ? -0.5 : d);
+}
+
+float peak_interp(const float *amp, const float *re, const float *im, int N, int k, PeakMethod m)
+{
+	if (k <= 0 || k >= N / 2)
+		return (float)k;
+
+	switch (m)
+	{
+	case PEAK_PARABOLIC:
+		return k + peak_parabola(amp[k - 1], amp[k], amp[k + 1]);
+	case PEAK_GAUSSIAN:
+		if (amp[k - 1] <= 0.0f || amp[k + 1] <= 0.0f)
+			return (float)k;
+		return k + peak_parabola(log(amp[k - 1]), log(amp[k]), log(amp[k + 1]));
+	case PEAK_JACOBSEN:
+	{
+		if (!re || !im)
+			return (float)k;
+		// Os tres bins ja calculados pela FFT (0 < k < N/2)
+		const complex double Xm = CMPLX(re[k - 1], im[k - 1]);
+		const complex double X0 = CMPLX(re[k], im[k]);
+		const complex double Xp = CMPLX(re[k + 1], im[k + 1]);
+		complex double den = 2.0 * X0 - Xm - Xp;
+		if (cabs(den) == 0.0)
+			return (float)k;
+		double d = -2.0 * creal((Xp - Xm) / den);
+		return (float)(k + (d > 0.5 ? 0.5 : d < -0.5 ? -0.5 : d));
+	}
+	default:
+		return (float)k;
+	}
+}
+
+float peak_zoom(const float *xw, int N, float kf, int zoom)
+{
+	if (zoom < 1)
+		return kf;
+	if (zoom > PEAK_MAX_ZOOM)
+		zoom = PEAK_MAX_ZOOM;
+
+	const double step = 1.0 / zoom;
+	double mag[2 * PEAK_MAX_ZOOM + 3];
+	// Pontos da grelha tres a tres (j - 1, j, j + 1)
+	for (int j = -zoom + 1; j <= zoom + 1; j += 3)
+	{
+		complex double X[3];
+		dtft3(xw, N, kf + j * step, step, X);
+		for (int t = 0; t < 3; t++)
+		{
+			const double k = kf + (j - 1 + t) * step;
+			mag[j - 1 + t + zoom] = (k < 0.0 || k > N / 2) ? 0.0 : cabs(X[t]);
+		}
+	}
+	int jbest = -zoom;
+	for (int j = -zoom; j <= zoom; j++)
+		if (mag[j + zoom] > mag[jbest + zoom])
+			jbest = j;
+	// Maximo na borda da grelha: sem vizinhos para a parabola
+	if (jbest == -zoom || jbest == zoom)
+		return (float)(kf + jbest * step);
+
+	const double *m = &mag[jbest + zoom];
+	return (float)(kf + (jbest + peak_parabola(m[-1], m[0], m[1])) * step);
+}
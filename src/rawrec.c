@@ -0,0 +1,300 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/mman.h>
+#include "rawrec.h"
+#include "config.h"
+#include "time_utils.h"
+
+// Blocos (arredondados para cima) de cada janela
+#define BLOCKS_OF(ms) ((int)(((long long)(ms) * SAMP_FREQ / 1000 + ABUFSIZE_SAMPLES - 1) / ABUFSIZE_SAMPLES))
+#define PRE_BLOCKS BLOCKS_OF(RAWREC_PRE_MS)
+#define POST_BLOCKS BLOCKS_OF(RAWREC_POST_MS)
+
+// Estado da captura de um canal
+enum
+{
+	JOB_IDLE = 0,	// livre (o dispatcher pode comecar outra)
+	JOB_COLLECTING, // o dispatcher junta os blocos depois da falha
+	JOB_READY		// completa: a thread de escrita grava e liberta
+};
+
+// NOTE - Estado de um canal
+// ring, n, head, job.blk/nblk e post_left so sao escritos pelo worker que
+// despacha o canal ate JOB_READY; depois disso a captura e da thread de escrita
+typedef struct
+{
+	BufferPool *pool;
+	AudioBuf *ring[PRE_BLOCKS]; // referencias aos ultimos blocos
+	int head, n;				// proximo slot e blocos no anel
+	int last_fault;				// ultimo valor visto na RTDB
+	uint32_t last_block;		// bloco desse valor
+
+	struct
+	{
+		_Alignas(CACHE_LINE) atomic_int state; // JOB_*
+		AudioBuf *blk[PRE_BLOCKS + POST_BLOCKS];
+		int nblk;
+		int post_left;
+		uint32_t trigger_block; // bloco da transicao (RtdbSample.block)
+	} job;
+
+	atomic_int held;		  // blocos retidos (anel + captura)
+	atomic_ulong captures;	  // WAV escritos
+	atomic_ulong skipped;	  // falhas com a captura anterior por escrever
+} RecChannel;
+
+static RecChannel *rec = NULL;
+static int nrec = 0;
+static RTDB *g_db = NULL;
+static char out_dir[256];
+
+static pthread_t writer_th;
+static volatile int writer_run = 0;
+
+int rawrec_extra_slots(void)
+{
+	// Anel cheio + uma captura com o anel anterior e os blocos depois da falha
+	return 2 * PRE_BLOCKS + POST_BLOCKS;
+}
+
+int rawrec_enabled(void) { return rec != NULL; }
+
+int rawrec_held(int ch)
+{
+	return rec && ch < nrec ? atomic_load_explicit(&rec[ch].held, memory_order_relaxed) : 0;
+}
+
+static void release(RecChannel *r, AudioBuf *b)
+{
+	buffer_pool_release(r->pool, b->data);
+	atomic_fetch_sub_explicit(&r->held, 1, memory_order_relaxed);
+}
+
+// NOTE - Passagem do anel para a captura (mais antigo primeiro)
+static void start_job(RecChannel *r, uint32_t trigger_block)
+{
+	int first = (r->head - r->n + PRE_BLOCKS) % PRE_BLOCKS;
+	for (int i = 0; i < r->n; i++)
+		r->job.blk[i] = r->ring[(first + i) % PRE_BLOCKS];
+	r->job.nblk = r->n;
+	r->job.post_left = POST_BLOCKS;
+	r->job.trigger_block = trigger_block;
+	r->n = 0;
+	r->head = 0;
+	atomic_store_explicit(&r->job.state, JOB_COLLECTING, memory_order_relaxed);
+}
+
+// NOTE - Chamada pelo dispatcher do canal para cada bloco
+// So ponteiros: o bloco fica no anel (ou na captura) com a referencia que o
+// dispatcher lhe deu; nada e copiado nem escrito aqui
+void rawrec_block(int ch, BufferPool *pool, AudioBuf *b)
+{
+	RecChannel *r = &rec[ch];
+	r->pool = pool;
+	atomic_fetch_add_explicit(&r->held, 1, memory_order_relaxed);
+
+	// Depois de uma falha os blocos seguintes vao para a captura
+	if (atomic_load_explicit(&r->job.state, memory_order_relaxed) == JOB_COLLECTING)
+	{
+		r->job.blk[r->job.nblk++] = b;
+		if (--r->job.post_left == 0)
+			atomic_store_explicit(&r->job.state, JOB_READY, memory_order_release);
+	}
+	else
+	{
+		if (r->n == PRE_BLOCKS)
+			release(r, r->ring[r->head]); // o mais antigo
+		else
+			r->n++;
+		r->ring[r->head] = b;
+		r->head = (r->head + 1) % PRE_BLOCKS;
+	}
+
+	// Transicao OK -> FAULT na RTDB (leitura do seqlock, sem bloquear)
+	RtdbSample s;
+	if (rtdb_read(g_db, RTDB_BEARING, ch, &s) != 1 || s.block == r->last_block)
+		return;
+	int rising = s.fault && !r->last_fault;
+	r->last_fault = s.fault;
+	r->last_block = s.block;
+	if (!rising)
+		return;
+	if (atomic_load_explicit(&r->job.state, memory_order_acquire) != JOB_IDLE)
+		atomic_fetch_add_explicit(&r->skipped, 1, memory_order_relaxed);
+	else
+		start_job(r, s.block);
+}
+
+// NOTE - Escrita de uma captura num WAV (float 32 bits, mono)
+// Os blocos da pool ja sao float32 (escala int16, sem DC): a escrita so os
+// traz para [-1, 1], sem perder a resolucao dos dispositivos de 32 bits
+// O ficheiro e dimensionado com ftruncate e preenchido pelo mapeamento
+static int write_wav(int ch, RecChannel *r)
+{
+	size_t samples = 0;
+	for (int i = 0; i < r->job.nblk; i++)
+		samples += r->job.blk[i]->len;
+	if (samples == 0)
+		return 0;
+	const size_t data_bytes = samples * sizeof(float);
+	const size_t size = 44 + data_bytes;
+
+	char path[sizeof(out_dir) + 64];
+	snprintf(path, sizeof(path), "%s/fault_ch%d_block%u.wav", out_dir, ch, r->job.trigger_block);
+	int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0)
+	{
+		perror(path);
+		return -1;
+	}
+	if (ftruncate(fd, (off_t)size) != 0)
+	{
+		perror(path);
+		close(fd);
+		return -1;
+	}
+	unsigned char *m = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (m == MAP_FAILED)
+	{
+		perror(path);
+		return -1;
+	}
+
+	// Cabecalho RIFF/WAVE canonico (little-endian)
+	uint32_t u32;
+	uint16_t u16;
+	memcpy(m, "RIFF", 4);
+	u32 = (uint32_t)(size - 8);
+	memcpy(m + 4, &u32, 4);
+	memcpy(m + 8, "WAVEfmt ", 8);
+	u32 = 16;
+	memcpy(m + 16, &u32, 4);
+	u16 = 3; // IEEE float
+	memcpy(m + 20, &u16, 2);
+	u16 = 1; // mono
+	memcpy(m + 22, &u16, 2);
+	u32 = SAMP_FREQ;
+	memcpy(m + 24, &u32, 4);
+	u32 = SAMP_FREQ * sizeof(float);
+	memcpy(m + 28, &u32, 4);
+	u16 = sizeof(float);
+	memcpy(m + 32, &u16, 2);
+	u16 = 32;
+	memcpy(m + 34, &u16, 2);
+	memcpy(m + 36, "data", 4);
+	u32 = (uint32_t)data_bytes;
+	memcpy(m + 40, &u32, 4);
+
+	float *p = (float *)(m + 44);
+	for (int i = 0; i < r->job.nblk; i++)
+	{
+		const AudioBuf *b = r->job.blk[i];
+		for (int j = 0; j < b->len; j++)
+			p[j] = b->data[j] * (1.0f / 32768.0f);
+		p += b->len;
+	}
+	msync(m, size, MS_ASYNC);
+	munmap(m, size);
+	printf("[RAWREC] ch %d: %s (%d blocks, %.2f s)\n", ch, path, r->job.nblk,
+		   (double)samples / SAMP_FREQ);
+	return 0;
+}
+
+// Grava a captura do canal e devolve os blocos a pool
+static void flush_job(int ch, RecChannel *r)
+{
+	if (write_wav(ch, r) == 0)
+		atomic_fetch_add_explicit(&r->captures, 1, memory_order_relaxed);
+	for (int i = 0; i < r->job.nblk; i++)
+		release(r, r->job.blk[i]);
+	r->job.nblk = 0;
+	atomic_store_explicit(&r->job.state, JOB_IDLE, memory_order_release);
+}
+
+// NOTE - Thread de escrita (SCHED_OTHER, polling: o dispatcher nao acorda ninguem)
+static void *writer_loop(void *arg)
+{
+	(void)arg;
+	struct timespec next;
+	clock_gettime(CLOCK_MONOTONIC, &next);
+	while (writer_run)
+	{
+		for (int c = 0; c < nrec; c++)
+			if (atomic_load_explicit(&rec[c].job.state, memory_order_acquire) == JOB_READY)
+				flush_job(c, &rec[c]);
+		add_ms(&next, RAWREC_POLL_MS);
+		clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+	}
+	return NULL;
+}
+
+int rawrec_start(const char *dir, RTDB *db, int nch)
+{
+	if (strlen(dir) >= sizeof(out_dir))
+	{
+		printf("rawrec: directory name too long\n");
+		return -1;
+	}
+	snprintf(out_dir, sizeof(out_dir), "%s", dir);
+	rec = aligned_alloc(CACHE_LINE, sizeof(RecChannel) * nch);
+	if (!rec)
+		return -1;
+	memset(rec, 0, sizeof(RecChannel) * nch);
+	for (int c = 0; c < nch; c++)
+	{
+		atomic_init(&rec[c].job.state, JOB_IDLE);
+		atomic_init(&rec[c].held, 0);
+		atomic_init(&rec[c].captures, 0);
+		atomic_init(&rec[c].skipped, 0);
+	}
+	nrec = nch;
+	g_db = db;
+
+	writer_run = 1;
+	if (pthread_create(&writer_th, NULL, writer_loop, NULL) != 0)
+	{
+		perror("rawrec");
+		writer_run = 0;
+		free(rec);
+		rec = NULL;
+		return -1;
+	}
+	printf("[RAWREC] %s: %d ms before and %d ms after each fault (%d + %d blocks per channel)\n",
+		   dir, RAWREC_PRE_MS, RAWREC_POST_MS, PRE_BLOCKS, POST_BLOCKS);
+	return 0;
+}
+
+void rawrec_stop(void)
+{
+	if (!rec)
+		return;
+	writer_run = 0;
+	pthread_join(writer_th, NULL);
+
+	unsigned long captures = 0, skipped = 0;
+	for (int c = 0; c < nrec; c++)
+	{
+		RecChannel *r = &rec[c];
+		// Captura incompleta (a fonte acabou antes do fim da janela)
+		if (atomic_load(&r->job.state) != JOB_IDLE)
+			flush_job(c, r);
+		while (r->n > 0)
+		{
+			release(r, r->ring[(r->head - r->n + PRE_BLOCKS) % PRE_BLOCKS]);
+			r->n--;
+		}
+		captures += atomic_load(&r->captures);
+		skipped += atomic_load(&r->skipped);
+	}
+	printf("[RAWREC] captures=%lu skipped=%lu\n", captures, skipped);
+	free(rec);
+	rec = NULL;
+	nrec = 0;
+}
@@ -0,0 +1,151 @@
+#include <stdio.h>
+#include <string.h>
+#include "rt_stats.h"
+#include "time_utils.h"
+#include "channel.h"
+
+RtStats gRtStats[RT_NTHREADS];
+volatile sig_atomic_t rt_stats_dump_request = 0;
+
+// NOTE - Indice do bin de um valor
+// v < 16: bin v (exato); senao o expoente escolhe o grupo de 16 bins
+// e os 4 bits a seguir ao bit mais significativo escolhem o bin
+static int hist_index(uint64_t v)
+{
+	if (v < RT_HIST_SUB)
+		return (int)v;
+	int e = 63 - __builtin_clzll(v);
+	if (e >= RT_HIST_MAX_LOG2)
+		return RT_HIST_BINS - 1;
+	int sub = (int)(v >> (e - RT_HIST_SUB_BITS)) & (RT_HIST_SUB - 1);
+	return (e - RT_HIST_SUB_BITS + 1) * RT_HIST_SUB + sub;
+}
+
+// Limite superior (exclusivo) dos valores do bin i
+static uint64_t hist_upper(int i)
+{
+	if (i < RT_HIST_SUB)
+		return (uint64_t)i + 1;
+	int e = i / RT_HIST_SUB + RT_HIST_SUB_BITS - 1;
+	uint64_t sub = (uint64_t)(i % RT_HIST_SUB);
+	return (RT_HIST_SUB + sub + 1) << (e - RT_HIST_SUB_BITS);
+}
+
+void rt_hist_record(RtHist *h, uint64_t ns)
+{
+	atomic_fetch_add_explicit(&h->bins[hist_index(ns)], 1, memory_order_relaxed);
+	atomic_fetch_add_explicit(&h->sum, ns, memory_order_relaxed);
+
+	unsigned long m = atomic_load_explicit(&h->max, memory_order_relaxed);
+	while (ns > m &&
+		   !atomic_compare_exchange_weak_explicit(&h->max, &m, ns,
+												  memory_order_relaxed, memory_order_relaxed))
+		;
+}
+
+void rt_hist_snapshot(const RtHist *h, RtHistSnapshot *s)
+{
+	// O count e a soma dos bins copiados: os percentis ficam coerentes
+	// mesmo que o escritor registe valores durante a copia
+	s->count = 0;
+	for (int i = 0; i < RT_HIST_BINS; i++)
+	{
+		s->bins[i] = atomic_load_explicit(&h->bins[i], memory_order_relaxed);
+		s->count += s->bins[i];
+	}
+	s->sum = atomic_load_explicit(&h->sum, memory_order_relaxed);
+	s->max = atomic_load_explicit(&h->max, memory_order_relaxed);
+}
+
+uint64_t rt_hist_percentile(const RtHistSnapshot *s, double p)
+{
+	if (s->count == 0)
+		return 0;
+	unsigned long target = (unsigned long)(p / 100.0 * s->count + 0.5);
+	if (target < 1)
+		target = 1;
+
+	unsigned long acc = 0;
+	for (int i = 0; i < RT_HIST_BINS; i++)
+	{
+		acc += s->bins[i];
+		if (acc >= target)
+		{
+			uint64_t up = hist_upper(i);
+			// nunca acima do maximo observado
+			return up < s->max ? up : s->max;
+		}
+	}
+	return s->max;
+}
+
+void rt_stats_init(RtThreadId id, const char *name, long period_ms, int queue)
+{
+	RtStats *st = &gRtStats[id];
+	memset(st, 0, sizeof(*st));
+	st->name = name;
+	st->period_ms = period_ms;
+	st->queue = queue;
+}
+
+uint64_t rt_activation_begin(RtStats *st, uint64_t release_ns)
+{
+	uint64_t t = now_ns();
+	atomic_fetch_add_explicit(&st->activations, 1, memory_order_relaxed);
+	rt_hist_record(&st->wakeup, t > release_ns ? t - release_ns : 0);
+	return t;
+}
+
+void rt_activation_end(RtStats *st, uint64_t start_ns, uint64_t deadline_ns)
+{
+	uint64_t t = now_ns();
+	rt_hist_record(&st->exec, t - start_ns);
+	if (deadline_ns && t > deadline_ns)
+		atomic_fetch_add_explicit(&st->deadline_misses, 1, memory_order_relaxed);
+}
+
+void rt_response(RtStats *st, uint64_t capture_ns)
+{
+	uint64_t t = now_ns();
+	rt_hist_record(&st->response, t > capture_ns ? t - capture_ns : 0);
+}
+
+// NOTE - Impressao dos snapshots (runtime via SIGUSR1 e no fim)
+static void print_hist(FILE *f, const char *what, const RtHist *h)
+{
+	// static: o snapshot tem ~5 KB, e so uma thread imprime de cada vez
+	static RtHistSnapshot s;
+	rt_hist_snapshot(h, &s);
+	if (s.count == 0)
+		return;
+	fprintf(f, "    %-9s n=%-7lu mean=%9.1f p50=%9.1f p99=%9.1f p99.9=%9.1f max=%9.1f us\n",
+			what, s.count, s.sum / 1e3 / s.count,
+			rt_hist_percentile(&s, 50.0) / 1e3, rt_hist_percentile(&s, 99.0) / 1e3,
+			rt_hist_percentile(&s, 99.9) / 1e3, s.max / 1e3);
+}
+
+void rt_stats_print(FILE *f)
+{
+	for (int i = 0; i < RT_NTHREADS; i++)
+	{
+		const RtStats *st = &gRtStats[i];
+		if (!st->name)
+			continue;
+		fprintf(f, "[RT] %-10s period=%4ld ms activations=%lu deadline misses=%lu",
+				st->name, st->period_ms,
+				atomic_load_explicit(&st->activations, memory_order_relaxed),
+				atomic_load_explicit(&st->deadline_misses, memory_order_relaxed));
+		if (st->queue >= 0)
+		{
+			// soma das filas de todos os canais
+			unsigned long drops = 0;
+			for (int c = 0; c < gNumChannels; c++)
+				drops += desc_queue_dropped(&gChannels[c].q[st->queue]);
+			fprintf(f, " queue drops=%lu", drops);
+		}
+		fprintf(f, "\n");
+		print_hist(f, "wakeup", &st->wakeup);
+		print_hist(f, "exec", &st->exec);
+		print_hist(f, "response", &st->response);
+	}
+}
@@ -1,41 +1,98 @@
+#include <string.h>
+#include <errno.h>
 #include "rtdb.h"
+#include "cpu_utils.h"
 
-void rtdb_init(RTDB *db)
+void rtdb_init(RTDB *db, int nch)
 {
-    pthread_mutex_init(&db->mtx, NULL);
-    db->speed_hz = 0.0f;
-    db->bearing_fault = 0;
-    db->direction = 0;
+    memset(db, 0, sizeof(*db));
+    db->nch = nch;
+    for (int c = 0; c < MAX_CHANNELS; c++)
+        for (int f = 0; f < RTDB_NUM_FIELDS; f++)
+            atomic_init(&db->f[c][f].seq, 0);
 }
 
-void rtdb_set_speed(RTDB *db, float hz)
+// NOTE - Escrita (seqlock)
+// O store de seq impar e ordenado antes dos dados pela fence release; o
+// store final (release) publica os dados
+void rtdb_write(RTDB *db, RtdbFieldId f, int ch, const RtdbSample *s)
 {
-    pthread_mutex_lock(&db->mtx);
-    db->speed_hz = hz;
-    pthread_mutex_unlock(&db->mtx);
+    RtdbField *fld = &db->f[ch][f];
+    unsigned seq = atomic_load_explicit(&fld->seq, memory_order_relaxed);
+    atomic_store_explicit(&fld->seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    fld->hist[fld->count & (RTDB_HISTORY - 1)] = *s;
+    fld->count++;
+
+    atomic_store_explicit(&fld->seq, seq + 2, memory_order_release);
+}
+
+// NOTE - Leitura (seqlock): copia ate n valores e repete se houve uma
+// escrita a meio. A copia pode ver dados a meio de uma escrita, mas so e
+// usada quando seq nao mudou. Desiste ao fim de RTDB_READ_RETRIES
+static int read_field(const RtdbField *fld, RtdbSample *out, int n)
+{
+    if (n > RTDB_HISTORY)
+        n = RTDB_HISTORY;
+    for (int retry = 0; retry < RTDB_READ_RETRIES; retry++)
+    {
+        unsigned s0 = atomic_load_explicit(&fld->seq, memory_order_acquire);
+        if (s0 & 1)
+        {
+            cpu_relax(); // escrita em curso (dura alguns ns)
+            continue;
+        }
+
+        uint32_t count = fld->count;
+        int m = count < (uint32_t)n ? (int)count : n;
+        for (int i = 0; i < m; i++)
+            out[i] = fld->hist[(count - 1 - i) & (RTDB_HISTORY - 1)];
+
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&fld->seq, memory_order_relaxed) == s0)
+            return m;
+        cpu_relax();
+    }
+    errno = EAGAIN;
+    return -1;
+}
+
+int rtdb_read(const RTDB *db, RtdbFieldId f, int ch, RtdbSample *out)
+{
+    int n = read_field(&db->f[ch][f], out, 1);
+    if (n != 1)
+        memset(out, 0, sizeof(*out));
+    return n;
+}
+
+int rtdb_history(const RTDB *db, RtdbFieldId f, int ch, RtdbSample *out, int n)
+{
+    return n > 0 ? read_field(&db->f[ch][f], out, n) : 0;
+}
+
+void rtdb_set_speed(RTDB *db, int ch, float hz, uint64_t t_capture, uint32_t block)
+{
+    RtdbSample s = {.t_capture = t_capture, .block = block, .speed_hz = hz};
+    rtdb_write(db, RTDB_SPEED, ch, &s);
 }
 
-float rtdb_get_speed(RTDB *db)
+float rtdb_get_speed(const RTDB *db, int ch)
 {
-    float v;
-    pthread_mutex_lock(&db->mtx);
-    v = db->speed_hz;
-    pthread_mutex_unlock(&db->mtx);
-    return v;
+    RtdbSample s;
+    rtdb_read(db, RTDB_SPEED, ch, &s);
+    return s.speed_hz;
 }
 
-void rtdb_set_bearing_fault(RTDB *db, int fault)
+void rtdb_set_bearing_fault(RTDB *db, int ch, int fault, uint64_t t_capture, uint32_t block)
 {
-    pthread_mutex_lock(&db->mtx);
-    db->bearing_fault = fault ? 1 : 0;
-    pthread_mutex_unlock(&db->mtx);
+    RtdbSample s = {.t_capture = t_capture, .block = block, .fault = fault ? 1 : 0};
+    rtdb_write(db, RTDB_BEARING, ch, &s);
 }
 
-int rtdb_get_bearing_fault(RTDB *db)
+int rtdb_get_bearing_fault(const RTDB *db, int ch)
 {
-    int v;
-    pthread_mutex_lock(&db->mtx);
-    v = db->bearing_fault;
-    pthread_mutex_unlock(&db->mtx);
-    return v;
+    RtdbSample s;
+    rtdb_read(db, RTDB_BEARING, ch, &s);
+    return s.fault;
 }
@@ -0,0 +1,146 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stddef.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "rtdb_shm.h"
+#include "time_utils.h"
+
+pid_t rtdb_shm_owner(const char *name)
+{
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0)
+        return 0;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(RtdbShmHeader))
+    {
+        // Sem header: o escritor morreu entre o shm_open e o ftruncate
+        close(fd);
+        return 0;
+    }
+    const RtdbShmHeader *h = mmap(NULL, sizeof(RtdbShmHeader), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (h == MAP_FAILED)
+        return 0;
+    pid_t pid = h->magic == RTDB_SHM_MAGIC ? h->pid : 0;
+    if (atomic_load_explicit(&h->state, memory_order_acquire) == RTDB_SHM_STOPPED)
+        pid = 0;
+    munmap((void *)h, sizeof(RtdbShmHeader));
+    // EPERM: o processo existe (de outro utilizador)
+    if (pid > 0 && kill(pid, 0) != 0 && errno == ESRCH)
+        pid = 0;
+    return pid;
+}
+
+RTDB *rtdb_shm_create(const char *name, int nch)
+{
+    int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0 && errno == EEXIST)
+    {
+        // Segmento de uma execucao que nao terminou: so e removido se o
+        // escritor ja nao estiver vivo
+        if (rtdb_shm_owner(name) > 0)
+        {
+            errno = EBUSY;
+            return NULL;
+        }
+        shm_unlink(name);
+        // Outra instancia pode ter criado o segmento entretanto: EEXIST
+        fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0644);
+    }
+    if (fd < 0)
+        return NULL;
+    if (ftruncate(fd, sizeof(RtdbShm)) != 0)
+    {
+        int e = errno;
+        close(fd);
+        shm_unlink(name);
+        errno = e;
+        return NULL;
+    }
+    RtdbShm *shm = mmap(NULL, sizeof(RtdbShm), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (shm == MAP_FAILED)
+    {
+        int e = errno;
+        shm_unlink(name);
+        errno = e;
+        return NULL;
+    }
+
+    // O segmento vem a zeros (state = RTDB_SHM_INIT)
+    RtdbShmHeader *h = &shm->hdr;
+    h->magic = RTDB_SHM_MAGIC;
+    h->version = RTDB_SHM_VERSION;
+    h->header_size = sizeof(RtdbShmHeader);
+    h->total_size = sizeof(RtdbShm);
+    h->db_offset = offsetof(RtdbShm, db);
+    h->max_channels = MAX_CHANNELS;
+    h->num_fields = RTDB_NUM_FIELDS;
+    h->history = RTDB_HISTORY;
+    h->field_size = sizeof(RtdbField);
+    h->sample_size = sizeof(RtdbSample);
+    h->pid = getpid();
+    h->t_start = now_ns();
+    rtdb_init(&shm->db, nch);
+    // Publica o layout: os clientes so o usam depois de verem RUNNING
+    atomic_store_explicit(&h->state, RTDB_SHM_RUNNING, memory_order_release);
+    return &shm->db;
+}
+
+void rtdb_shm_destroy(const char *name, RTDB *db)
+{
+    RtdbShm *shm = (RtdbShm *)((char *)db - offsetof(RtdbShm, db));
+    atomic_store_explicit(&shm->hdr.state, RTDB_SHM_STOPPED, memory_order_release);
+    munmap(shm, sizeof(RtdbShm));
+    // Clientes com o segmento mapeado continuam a ver os ultimos valores
+    shm_unlink(name);
+}
+
+const RtdbShm *rtdb_shm_open(const char *name)
+{
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0)
+        return NULL;
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        close(fd);
+        return NULL;
+    }
+    if (st.st_size != (off_t)sizeof(RtdbShm))
+    {
+        close(fd);
+        errno = st.st_size == 0 ? EAGAIN : EPROTO; // 0: o escritor ainda nao fez ftruncate
+        return NULL;
+    }
+    const RtdbShm *shm = mmap(NULL, sizeof(RtdbShm), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (shm == MAP_FAILED)
+        return NULL;
+
+    const RtdbShmHeader *h = &shm->hdr;
+    int err = 0;
+    if (atomic_load_explicit(&h->state, memory_order_acquire) == RTDB_SHM_INIT)
+        err = EAGAIN;
+    else if (h->magic != RTDB_SHM_MAGIC || h->version != RTDB_SHM_VERSION ||
+             h->header_size != sizeof(RtdbShmHeader) || h->total_size != sizeof(RtdbShm) ||
+             h->db_offset != offsetof(RtdbShm, db) || h->max_channels != MAX_CHANNELS ||
+             h->num_fields != RTDB_NUM_FIELDS || h->history != RTDB_HISTORY ||
+             h->field_size != sizeof(RtdbField) || h->sample_size != sizeof(RtdbSample))
+        err = EPROTO;
+    if (err)
+    {
+        munmap((void *)shm, sizeof(RtdbShm));
+        errno = err;
+        return NULL;
+    }
+    return shm;
+}
+
+void rtdb_shm_close(const RtdbShm *shm)
+{
+    munmap((void *)shm, sizeof(RtdbShm));
+}
@@ -0,0 +1,273 @@
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "rtlog.h"
+#include "time_utils.h"
+
+int rtlog_level = RTLOG_DEBUG;
+
+static const char level_tag[RTLOG_LEVELS] = {'D', 'I', 'W', 'E'};
+static const char *level_name[RTLOG_LEVELS] = {"debug", "info", "warn", "error"};
+
+// NOTE - Anel multi-produtor / consumidor unico (Vyukov)
+// slot i livre para a posicao pos quando seq == pos; publicado quando
+// seq == pos + 1; o consumidor liberta-o para a volta seguinte (pos + size)
+static RtlogRecord *ring = NULL;
+static _Alignas(CACHE_LINE) atomic_ulong head; // proxima posicao a reservar
+static _Alignas(CACHE_LINE) unsigned long tail; // so a thread de drenagem
+
+// Limite por nivel: janela de 1 s e registos aceites nela
+typedef struct
+{
+	_Alignas(CACHE_LINE) atomic_ulong window; // segundo da janela atual
+	atomic_uint count;
+	atomic_ulong full_drops; // anel cheio
+	atomic_ulong rate_drops; // limite excedido
+	unsigned rate;
+} LevelState;
+static LevelState levels[RTLOG_LEVELS];
+
+static FILE *out_f = NULL;
+static pthread_t drain_th;
+static volatile int drain_run = 0;
+static uint64_t t0;
+
+// NOTE - Produtor (qualquer thread, incluindo as RT)
+void rtlog_write(int level, const char *fmt, int nargs, const RtlogArg *args)
+{
+	if (!ring || level < 0 || level >= RTLOG_LEVELS)
+		return;
+	LevelState *ls = &levels[level];
+	uint64_t t = now_ns();
+
+	if (ls->rate)
+	{
+		unsigned long win = t / 1000000000ull;
+		unsigned long cur = atomic_load_explicit(&ls->window, memory_order_relaxed);
+		// Nova janela: quem ganhar o CAS recomeca a contagem
+		if (cur != win && atomic_compare_exchange_strong(&ls->window, &cur, win))
+			atomic_store_explicit(&ls->count, 0, memory_order_relaxed);
+		if (atomic_fetch_add_explicit(&ls->count, 1, memory_order_relaxed) >= ls->rate)
+		{
+			atomic_fetch_add_explicit(&ls->rate_drops, 1, memory_order_relaxed);
+			return;
+		}
+	}
+
+	unsigned long pos = atomic_load_explicit(&head, memory_order_relaxed);
+	RtlogRecord *r;
+	for (;;)
+	{
+		r = &ring[pos & (RTLOG_RING_SIZE - 1)];
+		unsigned long seq = atomic_load_explicit(&r->seq, memory_order_acquire);
+		long diff = (long)(seq - pos);
+		if (diff == 0)
+		{
+			if (atomic_compare_exchange_weak_explicit(&head, &pos, pos + 1,
+													  memory_order_relaxed, memory_order_relaxed))
+				break;
+		}
+		else if (diff < 0)
+		{
+			// Cheio: a drenagem ainda nao libertou o slot desta volta
+			atomic_fetch_add_explicit(&ls->full_drops, 1, memory_order_relaxed);
+			return;
+		}
+		else
+			pos = atomic_load_explicit(&head, memory_order_relaxed);
+	}
+
+	r->t = t;
+	r->fmt = fmt;
+	r->level = level;
+	r->nargs = nargs > RTLOG_MAX_ARGS ? RTLOG_MAX_ARGS : nargs;
+	memcpy(r->args, args, sizeof(RtlogArg) * r->nargs);
+	atomic_store_explicit(&r->seq, pos + 1, memory_order_release);
+}
+
+// NOTE - Formatacao de um registo (thread de drenagem)
+// Cada conversao do formato e passada ao snprintf com o argumento no tipo
+// certo; os modificadores de tamanho sao trocados por ll (inteiros guardados
+// como long long)
+static void format_record(const RtlogRecord *r, char *buf, size_t size)
+{
+	size_t n = 0;
+	int arg = 0;
+	const char *p = r->fmt;
+	while (*p && n + 1 < size)
+	{
+		if (*p != '%')
+		{
+			buf[n++] = *p++;
+			continue;
+		}
+		if (p[1] == '%')
+		{
+			buf[n++] = '%';
+			p += 2;
+			continue;
+		}
+
+		// %[flags][largura][.precisao][tamanho]conversao
+		char spec[32];
+		size_t k = 0;
+		spec[k++] = *p++;
+		while (*p && strchr("-+ #0123456789.", *p) && k < sizeof(spec) - 4)
+			spec[k++] = *p++;
+		while (*p && strchr("hlLqjzt", *p))
+			p++;
+		char conv = *p;
+		if (!conv)
+			break;
+		p++;
+
+		const RtlogArg a = arg < r->nargs ? r->args[arg] : (RtlogArg){0};
+		arg++;
+		int w;
+		if (strchr("diouxXc", conv))
+		{
+			if (conv != 'c')
+			{
+				spec[k++] = 'l';
+				spec[k++] = 'l';
+			}
+			spec[k++] = conv;
+			spec[k] = '\0';
+			if (conv == 'c')
+				w = snprintf(buf + n, size - n, spec, (int)a.i);
+			else if (conv == 'd' || conv == 'i')
+				w = snprintf(buf + n, size - n, spec, a.i);
+			else
+				w = snprintf(buf + n, size - n, spec, (unsigned long long)a.i);
+		}
+		else if (strchr("fFeEgGaA", conv))
+		{
+			spec[k++] = conv;
+			spec[k] = '\0';
+			w = snprintf(buf + n, size - n, spec, a.d);
+		}
+		else if (conv == 's')
+		{
+			spec[k++] = conv;
+			spec[k] = '\0';
+			w = snprintf(buf + n, size - n, spec, a.s ? a.s : "(null)");
+		}
+		else
+			w = snprintf(buf + n, size - n, "%%%c", conv); // nao suportada
+		if (w > 0)
+			n += (size_t)w < size - n ? (size_t)w : size - n - 1;
+	}
+	buf[n] = '\0';
+}
+
+// Consome os registos publicados; retorna quantos escreveu
+static int drain(void)
+{
+	char line[512];
+	int count = 0;
+	for (;;)
+	{
+		RtlogRecord *r = &ring[tail & (RTLOG_RING_SIZE - 1)];
+		if (atomic_load_explicit(&r->seq, memory_order_acquire) != tail + 1)
+			break;
+		format_record(r, line, sizeof(line));
+		fprintf(out_f, "%10.6f %c %s", (r->t - t0) / 1e9, level_tag[r->level], line);
+		atomic_store_explicit(&r->seq, tail + RTLOG_RING_SIZE, memory_order_release);
+		tail++;
+		count++;
+	}
+	if (count)
+		fflush(out_f);
+	return count;
+}
+
+// Descartes novos desde o ultimo aviso (um aviso por segundo no maximo)
+static void report_drops(int final)
+{
+	static unsigned long seen_full[RTLOG_LEVELS], seen_rate[RTLOG_LEVELS];
+	for (int l = 0; l < RTLOG_LEVELS; l++)
+	{
+		unsigned long full = atomic_load(&levels[l].full_drops);
+		unsigned long rate = atomic_load(&levels[l].rate_drops);
+		if (final ? (full || rate) : (full != seen_full[l] || rate != seen_rate[l]))
+			fprintf(out_f, "[LOG] %s: dropped %lu (ring full) + %lu (rate limit %u/s)%s\n",
+					level_name[l], full - (final ? 0 : seen_full[l]),
+					rate - (final ? 0 : seen_rate[l]), levels[l].rate, final ? " in total" : "");
+		seen_full[l] = full;
+		seen_rate[l] = rate;
+	}
+}
+
+static void *drain_loop(void *arg)
+{
+	(void)arg;
+	struct timespec next;
+	clock_gettime(CLOCK_MONOTONIC, &next);
+	uint64_t last_report = now_ns();
+	while (drain_run)
+	{
+		drain();
+		uint64_t now = now_ns();
+		if (now - last_report >= 1000000000ull)
+		{
+			report_drops(0);
+			last_report = now;
+		}
+		add_ms(&next, RTLOG_DRAIN_MS);
+		clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+	}
+	return NULL;
+}
+
+int rtlog_start(FILE *out, const unsigned *rate)
+{
+	static const unsigned default_rate[RTLOG_LEVELS] = {
+		RTLOG_RATE_DEBUG, RTLOG_RATE_INFO, RTLOG_RATE_WARN, RTLOG_RATE_ERROR};
+	if (!rate)
+		rate = default_rate;
+
+	ring = aligned_alloc(CACHE_LINE, sizeof(RtlogRecord) * RTLOG_RING_SIZE);
+	if (!ring)
+		return -1;
+	for (unsigned long i = 0; i < RTLOG_RING_SIZE; i++)
+		atomic_init(&ring[i].seq, i);
+	atomic_init(&head, 0);
+	tail = 0;
+	for (int l = 0; l < RTLOG_LEVELS; l++)
+	{
+		atomic_init(&levels[l].window, 0);
+		atomic_init(&levels[l].count, 0);
+		atomic_init(&levels[l].full_drops, 0);
+		atomic_init(&levels[l].rate_drops, 0);
+		levels[l].rate = rate[l];
+	}
+	out_f = out;
+	t0 = now_ns();
+
+	// Sem prioridade RT: herda SCHED_OTHER do main
+	drain_run = 1;
+	if (pthread_create(&drain_th, NULL, drain_loop, NULL) != 0)
+	{
+		perror("rtlog");
+		drain_run = 0;
+		free(ring);
+		ring = NULL;
+		return -1;
+	}
+	return 0;
+}
+
+void rtlog_stop(void)
+{
+	if (!ring)
+		return;
+	drain_run = 0;
+	pthread_join(drain_th, NULL);
+	// Chamado depois de parar os produtores: o que falta fica todo no anel
+	drain();
+	report_drops(1);
+	fflush(out_f);
+	RtlogRecord *r = ring;
+	ring = NULL;
+	free(r);
+}
@@ -0,0 +1,429 @@
+#include <stdio.h>
+#include <string.h>
+#include <sched.h>
+#include <pthread.h>
+#include "runtime.h"
+#include "wsdeque.h"
+#include "channel.h"
+#include "dispatcher.h"
+#include "audio_io.h"
+#include "notify.h"
+#include "time_utils.h"
+
+volatile int runtime_run = 1;
+
+static const Analysis *analyses[RUNTIME_MAX_ANALYSES];
+static int nanalyses = 0;
+
+// NOTE - Worker do runtime
+// Acordado pela captura de qualquer um dos seus canais (Channel.wake) e
+// por outros workers com tarefas a mais (parked 1 -> 0)
+typedef struct
+{
+	_Alignas(CACHE_LINE) Notifier ready;
+	atomic_int parked;				  // 1 enquanto dorme a espera de trabalho
+	WsDeque dq[RUNTIME_PRIOS];		  // tarefas (analise, canal) por prioridade
+	pthread_t th;
+	int id;
+	int cpu;						  // core onde fica fixado
+	int nch;
+	int ch[MAX_CHANNELS];			  // canais despachados por este worker
+	unsigned rng;					  // escolha da vitima dos roubos
+	// Contadores (so o proprio escreve, lidos no fim)
+	unsigned long tasks, steals, parks;
+} Worker;
+
+static Worker workers[RUNTIME_MAX_WORKERS];
+static int nworkers = 0;
+static atomic_int nparked;
+static _Thread_local Worker *self = NULL;
+
+// Modo periodico: libertacoes feitas pelo worker 0
+static uint64_t next_release[RUNTIME_MAX_ANALYSES];
+static _Atomic uint64_t cur_release[RUNTIME_MAX_ANALYSES]; // inicio do periodo atual
+
+// Uma tarefa e o par (analise, canal) numa palavra
+#define TASK(a, ch) ((long)(a) * MAX_CHANNELS + (ch))
+
+int runtime_register(const Analysis *a)
+{
+	if (nanalyses == RUNTIME_MAX_ANALYSES || a->prio < 0 || a->prio >= RUNTIME_PRIOS)
+		return -1;
+	analyses[nanalyses] = a;
+	return nanalyses++;
+}
+
+int runtime_analyses(void) { return nanalyses; }
+const Analysis *runtime_analysis(int i) { return analyses[i]; }
+
+// NOTE - Distribuicao dos canais pelos workers
+int runtime_init(int nw, const int *cpus, int ncpus)
+{
+	// Cores disponiveis: a lista dada ou a mascara de afinidade do processo
+	int avail[CPU_SETSIZE];
+	int navail = 0;
+	if (cpus && ncpus > 0)
+	{
+		for (int i = 0; i < ncpus && navail < CPU_SETSIZE; i++)
+			avail[navail++] = cpus[i];
+	}
+	else
+	{
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		if (sched_getaffinity(0, sizeof(set), &set) == 0)
+			for (int i = 0; i < CPU_SETSIZE; i++)
+				if (CPU_ISSET(i, &set))
+					avail[navail++] = i;
+		if (navail == 0)
+			avail[navail++] = 0;
+	}
+
+	// Por omissao um por core, ate ao n de canais; um n pedido com -w e
+	// respeitado (os workers sem canais so correm tarefas roubadas)
+	if (nw <= 0)
+	{
+		nw = navail;
+		if (nw > gNumChannels)
+			nw = gNumChannels;
+	}
+	if (nw > RUNTIME_MAX_WORKERS)
+	{
+		fprintf(stderr, "runtime: %d workers requested, using %d\n", nw, RUNTIME_MAX_WORKERS);
+		nw = RUNTIME_MAX_WORKERS;
+	}
+	if (nw < 1)
+		return -1;
+	nworkers = nw;
+	atomic_init(&nparked, 0);
+
+	for (int w = 0; w < nworkers; w++)
+	{
+		Worker *wk = &workers[w];
+		memset(wk, 0, sizeof(*wk));
+		notifier_init(&wk->ready);
+		atomic_init(&wk->parked, 0);
+		wk->id = w;
+		wk->cpu = avail[w % navail];
+		wk->rng = 0x9E3779B9u * (w + 1);
+		// No maximo uma tarefa por par (analise, canal) em todo o runtime
+		for (int p = 0; p < RUNTIME_PRIOS; p++)
+			if (wsdeque_init(&wk->dq[p], RUNTIME_MAX_ANALYSES * MAX_CHANNELS) != 0)
+				return -1;
+	}
+	for (int c = 0; c < gNumChannels; c++)
+	{
+		Worker *wk = &workers[c % nworkers];
+		wk->ch[wk->nch++] = c;
+		gChannels[c].worker = wk->id;
+		gChannels[c].wake = &wk->ready;
+	}
+
+	printf("[RUNTIME] %d channel(s), %d worker(s), %d analyses\n", gNumChannels, nworkers, nanalyses);
+	for (int w = 0; w < nworkers; w++)
+	{
+		printf("[RUNTIME] worker %d: cpu %d, channels", w, workers[w].cpu);
+		for (int i = 0; i < workers[w].nch; i++)
+			printf(" %d", workers[w].ch[i]);
+		printf("\n");
+	}
+	return 0;
+}
+
+// NOTE - Acorda um worker estacionado (se houver)
+static void wake_one(void)
+{
+	if (atomic_load_explicit(&nparked, memory_order_relaxed) == 0)
+		return;
+	for (int i = 0; i < nworkers; i++)
+	{
+		Worker *w = &workers[(self ? self->id + 1 + i : i) % nworkers];
+		int one = 1;
+		if (w != self && atomic_compare_exchange_strong(&w->parked, &one, 0))
+		{
+			notifier_signal(&w->ready);
+			return;
+		}
+	}
+}
+
+// Poe a tarefa no deque do worker atual; acorda outro se este ja tiver
+// trabalho (em qualquer prioridade: o speed e o bearing do mesmo bloco
+// ficam em deques diferentes)
+static void spawn(int a, int ch)
+{
+	Worker *w = self;
+	// Nao enche: no maximo uma tarefa por par (analise, canal)
+	wsdeque_push(&w->dq[analyses[a]->prio], TASK(a, ch));
+	// Ordem push -> leitura de nparked contra parked -> verificacao dos deques
+	// em park(): um dos dois ve o outro
+	atomic_thread_fence(memory_order_seq_cst);
+	long queued = 0;
+	for (int p = 0; p < RUNTIME_PRIOS; p++)
+		queued += wsdeque_size(&w->dq[p]);
+	if (queued > 1)
+		wake_one();
+}
+
+void runtime_notify(int a, int ch)
+{
+	int idle = 0;
+	if (atomic_compare_exchange_strong(&gChannels[ch].active[a], &idle, 1))
+		spawn(a, ch);
+}
+
+static void release_desc(const AudioDesc *d)
+{
+	spectrum_release(d->spec);
+	audio_release_buffer(d->ch, d->ptr);
+}
+
+// NOTE - Execucao de uma tarefa (analise a, canal ch)
+static void run_task(long task)
+{
+	const int a = (int)(task / MAX_CHANNELS), ch = (int)(task % MAX_CHANNELS);
+	const Analysis *an = analyses[a];
+	Channel *c = &gChannels[ch];
+	DescQueue *q = &c->q[a];
+	RtStats *st = &gRtStats[an->stats];
+	const uint64_t period_ns = an->period_ms * 1000000ull;
+	AudioDesc d;
+
+	if (periodic_mode)
+	{
+		// Uma ativacao por periodo, libertada no inicio do periodo
+		uint64_t release = atomic_load_explicit(&cur_release[a], memory_order_relaxed);
+		uint64_t start = rt_activation_begin(st, release);
+		int got = desc_queue_pop(q, &d);
+		AudioDesc next;
+		while (got && an->latest_only && desc_queue_pop(q, &next))
+		{
+			if (an->skip)
+				an->skip(&d);
+			release_desc(&d);
+			d = next;
+		}
+		if (got)
+		{
+			an->process(&d);
+			rt_response(st, d.t_capture);
+			release_desc(&d);
+		}
+		rt_activation_end(st, start, release + period_ns);
+		atomic_store_explicit(&c->active[a], 0, memory_order_release);
+		return;
+	}
+
+	// Por eventos: um descritor por tarefa, libertado na publicacao
+	if (desc_queue_pop(q, &d))
+	{
+		uint64_t start = rt_activation_begin(st, d.t_ready);
+		an->process(&d);
+		rt_response(st, d.t_capture);
+		release_desc(&d);
+		rt_activation_end(st, start, d.t_ready + period_ns);
+	}
+
+	// Ainda ha descritores: volta ao deque (atras das tarefas dos outros canais)
+	if (desc_queue_size(q) > 0)
+	{
+		spawn(a, ch);
+		return;
+	}
+	atomic_store(&c->active[a], 0);
+	// Um publish entre o size e o store viu active == 1 e nao lancou a tarefa
+	if (desc_queue_size(q) > 0)
+		runtime_notify(a, ch);
+}
+
+// NOTE - Procura de trabalho
+// Por prioridade: o proprio deque (LIFO) e depois roubo aos outros (FIFO),
+// a comecar numa vitima aleatoria
+static int find_task(Worker *w, long *task)
+{
+	for (int p = 0; p < RUNTIME_PRIOS; p++)
+	{
+		if (wsdeque_pop(&w->dq[p], task))
+			return 1;
+
+		w->rng = w->rng * 1103515245u + 12345u;
+		int first = (int)((w->rng >> 16) % nworkers);
+		for (int i = 0; i < nworkers; i++)
+		{
+			Worker *v = &workers[(first + i) % nworkers];
+			if (v == w)
+				continue;
+			if (wsdeque_steal(&v->dq[p], task))
+			{
+				w->steals++;
+				// A vitima ainda tem mais: acordar outro ajudante
+				if (wsdeque_size(&v->dq[p]) > 0)
+					wake_one();
+				return 1;
+			}
+		}
+	}
+	return 0;
+}
+
+static int any_task(void)
+{
+	for (int i = 0; i < nworkers; i++)
+		for (int p = 0; p < RUNTIME_PRIOS; p++)
+			if (wsdeque_size(&workers[i].dq[p]) > 0)
+				return 1;
+	return 0;
+}
+
+// NOTE - Estacionar ate haver trabalho (ou timeout_ms)
+// seen foi lido antes de procurar trabalho: um sinal depois disso nao se perde
+static void park(Worker *w, unsigned seen, long timeout_ms)
+{
+	atomic_store(&w->parked, 1);
+	atomic_fetch_add(&nparked, 1);
+	atomic_thread_fence(memory_order_seq_cst);
+	if (!any_task())
+	{
+		w->parks++;
+		notifier_wait(&w->ready, seen, timeout_ms);
+	}
+	atomic_store(&w->parked, 0);
+	atomic_fetch_sub(&nparked, 1);
+}
+
+// NOTE - Modo periodico: libertacao das tarefas de cada analise (worker 0)
+// Uma tarefa por canal no inicio de cada periodo; um canal cuja tarefa do
+// periodo anterior ainda nao acabou fica para o seguinte
+// Retorna o tempo ate a proxima libertacao (ns)
+static uint64_t periodic_release(void)
+{
+	uint64_t now = now_ns();
+	uint64_t wait = UINT64_MAX;
+	for (int a = 0; a < nanalyses; a++)
+	{
+		const uint64_t period_ns = analyses[a]->period_ms * 1000000ull;
+		if (now >= next_release[a])
+		{
+			atomic_store_explicit(&cur_release[a], next_release[a], memory_order_relaxed);
+			next_release[a] += period_ns;
+			// Atrasado mais de um periodo: as libertacoes perdidas nao se repetem
+			if (next_release[a] <= now)
+				next_release[a] = now + period_ns;
+			for (int ch = 0; ch < gNumChannels; ch++)
+				runtime_notify(a, ch);
+		}
+		if (next_release[a] - now < wait)
+			wait = next_release[a] - now;
+	}
+	return wait;
+}
+
+// NOTE - Thread de um worker
+// Cada volta despacha no maximo um bloco de cada canal seu (nenhum canal
+// monopoliza o worker) e depois corre uma tarefa; sem nada para fazer
+// estaciona: no modo por eventos ate a captura de um dos seus canais ou
+// outro worker o acordar, no modo periodico faz polling de 2 em 2 ms
+static void *worker_loop(void *arg)
+{
+	Worker *w = arg;
+	self = w;
+
+	while (runtime_run)
+	{
+		// lido antes de procurar trabalho para nao perder sinais
+		unsigned seen = notifier_seq(&w->ready);
+		long timeout_ms = WAIT_TIMEOUT_MS;
+		if (periodic_mode)
+		{
+			timeout_ms = 2;
+			if (w->id == 0)
+			{
+				uint64_t wait = periodic_release();
+				if (wait < 2000000ull)
+					timeout_ms = (long)((wait + 999999) / 1000000);
+			}
+		}
+
+		int busy = 0;
+		for (int i = 0; i < w->nch; i++)
+			busy |= dispatcher_dispatch(&gChannels[w->ch[i]]);
+
+		long task;
+		if (find_task(w, &task))
+		{
+			w->tasks++;
+			run_task(task);
+			continue;
+		}
+		if (busy || timeout_ms == 0)
+			continue;
+		park(w, seen, timeout_ms);
+	}
+	return NULL;
+}
+
+int runtime_start(int prio)
+{
+	uint64_t now = now_ns();
+	for (int a = 0; a < nanalyses; a++)
+	{
+		const Analysis *an = analyses[a];
+		rt_stats_init(an->stats, an->name, an->period_ms, a);
+		if (an->init)
+			an->init(gNumChannels);
+		// A primeira ativacao periodica e logo no arranque
+		next_release[a] = now;
+	}
+
+	for (int i = 0; i < nworkers; i++)
+	{
+		Worker *w = &workers[i];
+		if (pthread_create(&w->th, NULL, worker_loop, w) != 0)
+		{
+			perror("runtime");
+			// parar os que ja arrancaram
+			runtime_run = 0;
+			for (int j = 0; j < i; j++)
+				pthread_join(workers[j].th, NULL);
+			return -1;
+		}
+
+		// Fixar ao core: a cache e o estado dos canais ficam nesse core
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		CPU_SET(w->cpu, &set);
+		int ret = pthread_setaffinity_np(w->th, sizeof(set), &set);
+		if (ret != 0)
+			fprintf(stderr, "runtime: worker %d: cannot pin to cpu %d: %s\n",
+					i, w->cpu, strerror(ret));
+
+		// Prioridade RT (a das antigas threads de analise)
+		if (prio > 0)
+		{
+			struct sched_param sp = {.sched_priority = prio};
+			ret = pthread_setschedparam(w->th, SCHED_FIFO, &sp);
+			if (ret != 0)
+				fprintf(stderr, "runtime: worker %d: SCHED_FIFO %d: %s\n", i, prio, strerror(ret));
+		}
+	}
+	return 0;
+}
+
+void runtime_join(void)
+{
+	for (int i = 0; i < nworkers; i++)
+		pthread_join(workers[i].th, NULL);
+	for (int a = 0; a < nanalyses; a++)
+		if (analyses[a]->fini)
+			analyses[a]->fini();
+	for (int i = 0; i < nworkers; i++)
+		for (int p = 0; p < RUNTIME_PRIOS; p++)
+			wsdeque_destroy(&workers[i].dq[p]);
+}
+
+void runtime_print_stats(FILE *f)
+{
+	for (int i = 0; i < nworkers; i++)
+		fprintf(f, "[RUNTIME] worker %d: tasks=%lu steals=%lu parks=%lu\n",
+				i, workers[i].tasks, workers[i].steals, workers[i].parks);
+}
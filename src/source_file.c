@@ -0,0 +1,250 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "audio_source.h"
+#include "audio_io.h"
+#include "time_utils.h"
+#include "config.h"
+
+// NOTE - Fonte de audio a partir de ficheiro (WAV ou raw PCM)
+// O ficheiro e mapeado com mmap e uma thread de alimentação entrega blocos
+// de ABUFSIZE_SAMPLES pelo mesmo caminho que a callback SDL
+typedef struct
+{
+	AudioSource base;
+
+	int fd;
+	const uint8_t *map; // ficheiro inteiro mapeado
+	size_t map_size;
+
+	const uint8_t *pcm; // inicio das amostras (intercaladas se channels > 1, formato base.fmt)
+	long nframes;		// n de amostras por canal
+	long pos;			// proxima amostra a entregar
+	int pace;			// SOURCE_PACE_*
+
+	pthread_t th;
+	volatile int running;
+	volatile int done;
+} FileSource;
+
+static uint16_t le16(const uint8_t *p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+static uint32_t le32(const uint8_t *p) { return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24); }
+
+// NOTE - Percorre os chunks RIFF a procura de "fmt " e "data"
+static int parse_wav(FileSource *fs)
+{
+	const uint8_t *m = fs->map;
+	size_t size = fs->map_size;
+
+	if (size < 12 || memcmp(m, "RIFF", 4) != 0 || memcmp(m + 8, "WAVE", 4) != 0)
+	{
+		printf("file: not a RIFF/WAVE file\n");
+		return -1;
+	}
+
+	int have_fmt = 0, bits = 0;
+	size_t off = 12;
+	while (off + 8 <= size)
+	{
+		const uint8_t *ck = m + off;
+		uint32_t cksize = le32(ck + 4);
+		const uint8_t *body = ck + 8;
+		if (off + 8 + cksize > size)
+			cksize = (uint32_t)(size - off - 8); // data truncado: usar o que existe
+
+		if (memcmp(ck, "fmt ", 4) == 0 && cksize >= 16)
+		{
+			uint16_t tag = le16(body);
+			if (tag == 0xFFFE && cksize >= 26) // WAVE_FORMAT_EXTENSIBLE: subformato
+				tag = le16(body + 24);
+			fs->base.channels = le16(body + 2);
+			fs->base.rate = (int)le32(body + 4);
+			bits = le16(body + 14);
+			// PCM 16/32 bits ou float 32 bits (tag 3), sempre little-endian
+			IngestType type = tag == 3 ? INGEST_F32 : bits == 16 ? INGEST_S16 : INGEST_S32;
+			if ((tag != 1 && tag != 3) || (tag == 1 && bits != 16 && bits != 32) ||
+				(tag == 3 && bits != 32) ||
+				ingest_format_init(&fs->base.fmt, type, 0, fs->base.channels) != 0)
+			{
+				printf("file: unsupported WAV format (tag=%u bits=%d)\n", tag, bits);
+				return -1;
+			}
+			// rate entra no periodo da thread de alimentacao
+			if (fs->base.rate <= 0 || fs->base.channels > MAX_CHANNELS)
+			{
+				printf("file: invalid WAV header (rate=%d channels=%d, max %d)\n",
+					   fs->base.rate, fs->base.channels, MAX_CHANNELS);
+				return -1;
+			}
+			have_fmt = 1;
+		}
+		else if (memcmp(ck, "data", 4) == 0)
+		{
+			if (!have_fmt)
+			{
+				printf("file: data chunk before fmt chunk\n");
+				return -1;
+			}
+			fs->pcm = body;
+			fs->nframes = cksize / fs->base.fmt.frame_bytes;
+			return 0;
+		}
+		off += 8 + cksize + (cksize & 1); // chunks alinhados a 2 bytes
+	}
+
+	printf("file: no data chunk\n");
+	return -1;
+}
+
+// NOTE - Thread de alimentação
+static void *feeder_loop(void *arg)
+{
+	FileSource *fs = arg;
+	const int ch = fs->base.channels;
+	const long frame_bytes = fs->base.fmt.frame_bytes;
+	const long block_ns = (long)((double)ABUFSIZE_SAMPLES * 1e9 / fs->base.rate);
+
+	struct timespec next_time;
+	clock_gettime(CLOCK_MONOTONIC, &next_time);
+
+	// Os blocos tem de estar completos para a FFT; o resto final e ignorado
+	while (fs->running && fs->pos + ABUFSIZE_SAMPLES <= fs->nframes)
+	{
+		// Cada canal do ficheiro vai para o seu canal do pipeline
+		const uint8_t *src = fs->pcm + fs->pos * frame_bytes;
+
+		if (fs->pace == SOURCE_PACE_FAST)
+		{
+			// Nao ultrapassar a capacidade das filas: os consumidores ditam o ritmo
+			int space = 1;
+			for (int c = 0; c < ch && space; c++)
+				space = audio_capture_wait_space(fs->base.first_channel + c,
+												 DESCRIPTOR_QUEUE_CAPACITY, WAIT_TIMEOUT_MS);
+			if (!space)
+				continue;
+		}
+		else
+		{
+			// O bloco "demora" ABUFSIZE_SAMPLES / rate a ser gravado
+			add_ns(&next_time, block_ns);
+			clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next_time, NULL);
+		}
+
+		audio_capture_push_frames(fs->base.first_channel, &fs->base.fmt, src, ABUFSIZE_SAMPLES);
+		fs->pos += ABUFSIZE_SAMPLES;
+	}
+
+	fs->done = 1;
+	return NULL;
+}
+
+static int file_start(AudioSource *s)
+{
+	FileSource *fs = (FileSource *)s;
+	fs->running = 1;
+	if (pthread_create(&fs->th, NULL, feeder_loop, fs) != 0)
+	{
+		perror("file feeder");
+		fs->running = 0;
+		return -1;
+	}
+	return 0;
+}
+
+static void file_stop(AudioSource *s)
+{
+	FileSource *fs = (FileSource *)s;
+	if (fs->running)
+	{
+		fs->running = 0;
+		pthread_join(fs->th, NULL);
+	}
+}
+
+static int file_finished(AudioSource *s)
+{
+	return ((FileSource *)s)->done;
+}
+
+static void file_close(AudioSource *s)
+{
+	FileSource *fs = (FileSource *)s;
+	file_stop(s);
+	if (fs->map)
+		munmap((void *)fs->map, fs->map_size);
+	if (fs->fd >= 0)
+		close(fs->fd);
+	free(fs);
+}
+
+AudioSource *audio_source_file_open(const char *path, int raw, int pace, int first_channel)
+{
+	FileSource *fs = calloc(1, sizeof(*fs));
+	if (!fs)
+		return NULL;
+	fs->fd = -1;
+	fs->pace = pace;
+	fs->base.first_channel = first_channel;
+	fs->base.name = "file";
+	fs->base.start = file_start;
+	fs->base.stop = file_stop;
+	fs->base.finished = file_finished;
+	fs->base.close = file_close;
+
+	fs->fd = open(path, O_RDONLY);
+	struct stat st;
+	if (fs->fd < 0 || fstat(fs->fd, &st) != 0)
+	{
+		perror(path);
+		file_close(&fs->base);
+		return NULL;
+	}
+	fs->map_size = (size_t)st.st_size;
+	if (fs->map_size > 0)
+	{
+		void *m = mmap(NULL, fs->map_size, PROT_READ, MAP_PRIVATE, fs->fd, 0);
+		if (m == MAP_FAILED)
+		{
+			perror("mmap");
+			file_close(&fs->base);
+			return NULL;
+		}
+		fs->map = m;
+		// Leitura sequencial: pedir read-ahead ao kernel
+		madvise(m, fs->map_size, MADV_SEQUENTIAL);
+	}
+
+	if (raw)
+	{
+		// raw: S16LE mono a SAMP_FREQ
+		fs->base.rate = SAMP_FREQ;
+		fs->base.channels = 1;
+		ingest_format_init(&fs->base.fmt, INGEST_S16, 0, 1);
+		fs->pcm = fs->map;
+		fs->nframes = (long)(fs->map_size / sizeof(int16_t));
+	}
+	else if (parse_wav(fs) != 0)
+	{
+		file_close(&fs->base);
+		return NULL;
+	}
+
+	if (first_channel + fs->base.channels > MAX_CHANNELS)
+	{
+		printf("file: %d channels, at most %d in total\n", fs->base.channels, MAX_CHANNELS);
+		file_close(&fs->base);
+		return NULL;
+	}
+	if (fs->base.rate != SAMP_FREQ)
+		printf("file: warning: %d Hz file, analyses assume %d Hz\n", fs->base.rate, SAMP_FREQ);
+	printf("Using file %s (%s %s, %d Hz, %d ch, %.1f s, %s)\n", path, raw ? "raw" : "wav",
+		   ingest_format_name(&fs->base.fmt), fs->base.rate, fs->base.channels, (double)fs->nframes / fs->base.rate,
+		   pace == SOURCE_PACE_FAST ? "fast" : "real time");
+	return &fs->base;
+}
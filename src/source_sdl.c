@@ -0,0 +1,163 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <SDL.h>
+#include "audio_source.h"
+#include "audio_io.h"
+#include "config.h"
+
+// NOTE - Fonte de audio SDL (dispositivo de captura)
+typedef struct
+{
+	AudioSource base;
+	SDL_AudioDeviceID dev;
+} SdlSource;
+
+// NOTE - Formato obtido do dispositivo -> formato da ingestao
+// Retorna -1 para os formatos que a ingestao nao converte (8 bits)
+static int sdl_ingest_format(SDL_AudioFormat f, int channels, IngestFormat *out)
+{
+	IngestType t;
+	if (SDL_AUDIO_ISFLOAT(f) && SDL_AUDIO_BITSIZE(f) == 32)
+		t = INGEST_F32;
+	else if (SDL_AUDIO_ISSIGNED(f) && SDL_AUDIO_BITSIZE(f) == 32)
+		t = INGEST_S32;
+	else if (SDL_AUDIO_BITSIZE(f) == 16)
+		t = SDL_AUDIO_ISSIGNED(f) ? INGEST_S16 : INGEST_U16;
+	else
+		return -1;
+	return ingest_format_init(out, t, SDL_AUDIO_ISBIGENDIAN(f) != 0, channels);
+}
+
+static int sdl_start(AudioSource *s)
+{
+	// Iniciar gravacao
+	SDL_PauseAudioDevice(((SdlSource *)s)->dev, SDL_FALSE);
+	return 0;
+}
+
+static void sdl_stop(AudioSource *s)
+{
+	SDL_PauseAudioDevice(((SdlSource *)s)->dev, SDL_TRUE);
+}
+
+static int sdl_finished(AudioSource *s)
+{
+	(void)s;
+	return 0;
+}
+
+static void sdl_close(AudioSource *s)
+{
+	SdlSource *ss = (SdlSource *)s;
+	SDL_CloseAudioDevice(ss->dev);
+	for (int c = 0; c < s->channels; c++)
+		gRecDev[s->first_channel + c] = 0;
+	// SDL_Init e contado: cada fonte aberta fez um
+	SDL_QuitSubSystem(SDL_INIT_AUDIO);
+	free(ss);
+}
+
+AudioSource *audio_source_sdl_open(int index, int channels, int first_channel)
+{
+	if (channels < 1 || first_channel + channels > MAX_CHANNELS)
+	{
+		printf("Too many channels (max %d)\n", MAX_CHANNELS);
+		return NULL;
+	}
+	if (SDL_InitSubSystem(SDL_INIT_AUDIO) < 0)
+	{
+		printf("SDL init failed: %s\n", SDL_GetError());
+		return NULL;
+	}
+
+	// Listar dispositivos de captura e pedir índice (compatível com original)
+	int ndev = SDL_GetNumAudioDevices(SDL_TRUE);
+	if (ndev < 1)
+	{
+		printf("No capture devices: %s\n", SDL_GetError());
+		SDL_QuitSubSystem(SDL_INIT_AUDIO);
+		return NULL;
+	}
+	for (int i = 0; i < ndev; ++i)
+	{
+		printf("%d - %s\n", i, SDL_GetAudioDeviceName(i, SDL_TRUE));
+	}
+	if (index < 0)
+	{
+		printf("Choose audio index: ");
+		fflush(stdout);
+		if (scanf("%d", &index) != 1)
+		{
+			puts("Invalid input");
+			SDL_QuitSubSystem(SDL_INIT_AUDIO);
+			return NULL;
+		}
+	}
+	if (index < 0 || index >= ndev)
+	{
+		printf("Invalid device ID. Must be 0..%d\n", ndev - 1);
+		SDL_QuitSubSystem(SDL_INIT_AUDIO);
+		return NULL;
+	}
+	printf("Using audio capture device %d - %s\n", index, SDL_GetAudioDeviceName(index, SDL_TRUE));
+
+	SdlSource *ss = calloc(1, sizeof(*ss));
+	if (!ss)
+	{
+		SDL_QuitSubSystem(SDL_INIT_AUDIO);
+		return NULL;
+	}
+
+	// Abrir device de gravação
+	// A callback recebe a fonte: os canais do stream vao para first_channel..
+	SDL_AudioSpec desired;
+	SDL_zero(desired);
+	desired.freq = SAMP_FREQ;
+	desired.format = FORMAT;
+	desired.channels = channels;
+	desired.samples = ABUFSIZE_SAMPLES;
+	desired.callback = audio_recording_callback;
+	desired.userdata = &ss->base;
+
+	// Sem SDL_AUDIO_ALLOW_CHANNELS_CHANGE: o n de canais e o pedido (os canais do
+	// pipeline ja estao reservados), o SDL converte se o dispositivo tiver outro
+	SDL_AudioSpec obtained;
+	SDL_AudioDeviceID rec = SDL_OpenAudioDevice(SDL_GetAudioDeviceName(index, SDL_TRUE), SDL_TRUE,
+												&desired, &obtained, SDL_AUDIO_ALLOW_FORMAT_CHANGE);
+
+	// NOTE - O formato obtido pode ser outro: a ingestao converte os de 16 e
+	// 32 bits; nos restantes reabrimos sem mudanca de formato (o SDL converte)
+	if (rec && sdl_ingest_format(obtained.format, obtained.channels, &ss->base.fmt) != 0)
+	{
+		SDL_CloseAudioDevice(rec);
+		rec = SDL_OpenAudioDevice(SDL_GetAudioDeviceName(index, SDL_TRUE), SDL_TRUE,
+								  &desired, &obtained, 0);
+		if (rec && sdl_ingest_format(obtained.format, obtained.channels, &ss->base.fmt) != 0)
+		{
+			SDL_CloseAudioDevice(rec);
+			rec = 0;
+		}
+	}
+	if (!rec)
+	{
+		printf("Open capture failed: %s\n", SDL_GetError());
+		free(ss);
+		SDL_QuitSubSystem(SDL_INIT_AUDIO);
+		return NULL;
+	}
+	printf("Capture format %s, %d ch, %d Hz (ingest %s)\n", ingest_format_name(&ss->base.fmt),
+		   obtained.channels, obtained.freq, ss->base.fmt.kernel);
+	for (int c = 0; c < channels; c++)
+		gRecDev[first_channel + c] = rec;
+
+	ss->dev = rec;
+	ss->base.name = "sdl";
+	ss->base.rate = obtained.freq;
+	ss->base.channels = obtained.channels;
+	ss->base.first_channel = first_channel;
+	ss->base.start = sdl_start;
+	ss->base.stop = sdl_stop;
+	ss->base.finished = sdl_finished;
+	ss->base.close = sdl_close;
+	return &ss->base;
+}
@@ -0,0 +1,393 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "audio_source.h"
+#include "audio_io.h"
+#include "time_utils.h"
+#include "config.h"
+
+#define SYNTH_MAX_CHANNELS MAX_CHANNELS
+// n de blocos de verdade guardados por canal (indexados pelo n do bloco)
+#define TRUTH_RING 1024
+
+// NOTE - Verdade de referencia de um bloco de um canal
+typedef struct
+{
+	atomic_uint seq; // n do bloco + 1 (0 = vazio)
+	float speed_hz;	 // fundamental no centro da janela do speed
+	int fault;		 // componente de falha presente
+} Truth;
+
+// NOTE - Fonte sintetica
+// Uma thread gera blocos com fase continua entre blocos e entrega-os
+// pelo mesmo caminho que a callback SDL (audio_capture_push)
+typedef struct
+{
+	AudioSource base;
+	SynthParams p;
+
+	pthread_t th;
+	volatile int running;
+	volatile int done;
+
+	double t;						   // tempo simulado (s)
+	double phase[SYNTH_MAX_CHANNELS];  // fase da fundamental de cada canal
+	double fphase[SYNTH_MAX_CHANNELS]; // fase da componente de falha
+	uint64_t rng;					   // xorshift64
+	int16_t block[SYNTH_MAX_CHANNELS][ABUFSIZE_SAMPLES];
+
+	Truth truth[SYNTH_MAX_CHANNELS][TRUTH_RING];
+} SynthSource;
+
+// fonte sintetica ativa (para os truth_report_*)
+static SynthSource *g_synth = NULL;
+
+// Erros acumulados
+// Um speed conta como certo com erro ate SPEED_TOL_HZ (meta abaixo do Hz)
+#define SPEED_TOL_HZ 1.0f
+static struct
+{
+	atomic_ulong n_speed;
+	atomic_ulong speed_hits;	// erro ate SPEED_TOL_HZ
+	double speed_abs_err; // soma |erro| (so escrito pela thread de speed, todos os canais)
+	float speed_max_err;
+	atomic_ulong tp, fp, fn, tn; // matriz de confusao da falha
+} score;
+
+void synth_params_default(SynthParams *p)
+{
+	p->f0_start = 300.0;
+	p->f0_end = 300.0;
+	p->ramp_s = 0.0;
+	p->harmonics = 4;
+	p->amp = 6000.0;
+	p->harm_decay = 0.5;
+	p->fault_hz = 0.0;
+	p->fault_amp = 0.5;
+	p->fault_start_s = 0.0;
+	p->noise = 100.0;
+	p->channels = 1;
+	p->duration_s = 10.0;
+	p->rate_mult = 1.0;
+}
+
+int synth_params_parse(SynthParams *p, const char *spec)
+{
+	char buf[256];
+	snprintf(buf, sizeof(buf), "%s", spec);
+
+	char *save = NULL;
+	for (char *kv = strtok_r(buf, ",", &save); kv; kv = strtok_r(NULL, ",", &save))
+	{
+		char *eq = strchr(kv, '=');
+		if (!eq)
+			return -1;
+		*eq = '\0';
+		const char *k = kv;
+		double v = atof(eq + 1);
+
+		if (!strcmp(k, "f0"))
+			p->f0_start = p->f0_end = v;
+		else if (!strcmp(k, "f1"))
+			p->f0_end = v;
+		else if (!strcmp(k, "ramp"))
+			p->ramp_s = v;
+		else if (!strcmp(k, "harm"))
+			p->harmonics = (int)v;
+		else if (!strcmp(k, "amp"))
+			p->amp = v;
+		else if (!strcmp(k, "decay"))
+			p->harm_decay = v;
+		else if (!strcmp(k, "fault"))
+			p->fault_hz = v;
+		else if (!strcmp(k, "famp"))
+			p->fault_amp = v;
+		else if (!strcmp(k, "fstart"))
+			p->fault_start_s = v;
+		else if (!strcmp(k, "noise"))
+			p->noise = v;
+		else if (!strcmp(k, "ch"))
+			p->channels = (int)v;
+		else if (!strcmp(k, "dur"))
+			p->duration_s = v;
+		else if (!strcmp(k, "x"))
+			p->rate_mult = v;
+		else
+			return -1;
+	}
+
+	if (p->harmonics < 1 || p->channels < 1 || p->channels > SYNTH_MAX_CHANNELS || p->rate_mult < 0.0)
+		return -1;
+	return 0;
+}
+
+// NOTE - Geracao
+
+static double rand_uniform(SynthSource *s)
+{
+	uint64_t x = s->rng;
+	x ^= x << 13;
+	x ^= x >> 7;
+	x ^= x << 17;
+	s->rng = x;
+	return ((x >> 11) + 0.5) * (1.0 / 9007199254740992.0); // (0,1)
+}
+
+static double rand_gauss(SynthSource *s)
+{
+	// Box-Muller
+	double u1 = rand_uniform(s), u2 = rand_uniform(s);
+	return sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2);
+}
+
+static double f0_at(const SynthParams *p, double t)
+{
+	if (p->ramp_s <= 0.0 || t >= p->ramp_s)
+		return p->f0_end;
+	return p->f0_start + (p->f0_end - p->f0_start) * t / p->ramp_s;
+}
+
+static void generate_block(SynthSource *s)
+{
+	const SynthParams *p = &s->p;
+	const double dt = 1.0 / SAMP_FREQ;
+	const int fault_on = p->fault_hz > 0.0 && s->t >= p->fault_start_s;
+
+	for (int c = 0; c < p->channels; c++)
+	{
+		const double speed_mult = 1.0 + 0.05 * c;
+		double ph = s->phase[c];
+		double fph = s->fphase[c];
+
+		for (int i = 0; i < ABUFSIZE_SAMPLES; i++)
+		{
+			double f0 = f0_at(p, s->t + i * dt) * speed_mult;
+
+			// Harmonicas por recorrencia: sin((h+1)x) = 2cos(x)sin(hx) - sin((h-1)x)
+			double sn = sin(ph), c2 = 2.0 * cos(ph);
+			double s_prev = 0.0, s_cur = sn, a = p->amp, v = 0.0;
+			for (int h = 1; h <= p->harmonics; h++)
+			{
+				v += a * s_cur;
+				double s_next = c2 * s_cur - s_prev;
+				s_prev = s_cur;
+				s_cur = s_next;
+				a *= p->harm_decay;
+			}
+
+			if (fault_on)
+			{
+				v += p->fault_amp * p->amp * sin(fph);
+				fph += 2.0 * M_PI * p->fault_hz * dt;
+			}
+			if (p->noise > 0.0)
+				v += p->noise * rand_gauss(s);
+
+			if (v > 32767.0)
+				v = 32767.0;
+			if (v < -32768.0)
+				v = -32768.0;
+			s->block[c][i] = (int16_t)v;
+
+			ph += 2.0 * M_PI * f0 * dt;
+		}
+		s->phase[c] = fmod(ph, 2.0 * M_PI);
+		s->fphase[c] = fmod(fph, 2.0 * M_PI);
+	}
+}
+
+static void *synth_loop(void *arg)
+{
+	SynthSource *s = arg;
+	const SynthParams *p = &s->p;
+	const double block_s = (double)ABUFSIZE_SAMPLES / SAMP_FREQ;
+	// O speed ve as ultimas ANALYSIS_N amostras decimadas, que acabam no fim
+	// do bloco: a verdade e a frequencia no centro dessa janela
+	const double window_s = (double)ANALYSIS_N * DECIM_FACTOR / SAMP_FREQ;
+	const double center_s = block_s - window_s / 2;
+	const long block_ns = p->rate_mult > 0.0 ? (long)(block_s * 1e9 / p->rate_mult) : 0;
+
+	struct timespec next_time;
+	clock_gettime(CLOCK_MONOTONIC, &next_time);
+
+	while (s->running && (p->duration_s <= 0.0 || s->t + block_s <= p->duration_s))
+	{
+		float truth_hz = (float)f0_at(p, s->t + center_s > 0.0 ? s->t + center_s : 0.0);
+		int truth_fault = p->fault_hz > 0.0 && s->t >= p->fault_start_s;
+		generate_block(s);
+		s->t += block_s;
+
+		if (block_ns == 0)
+		{
+			// Sem ritmo fixo: os consumidores ditam o ritmo
+			int space = 1;
+			for (int c = 0; c < p->channels && space; c++)
+				space = audio_capture_wait_space(s->base.first_channel + c,
+												 DESCRIPTOR_QUEUE_CAPACITY, WAIT_TIMEOUT_MS);
+			if (!space)
+				continue;
+		}
+		else
+		{
+			add_ns(&next_time, block_ns % 1000000000L);
+			next_time.tv_sec += block_ns / 1000000000L;
+			clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next_time, NULL);
+		}
+
+		for (int c = 0; c < p->channels; c++)
+		{
+			// A verdade e registada antes de entregar o bloco: os consumidores podem
+			// acabar de o processar antes de audio_capture_push retornar.
+			// Se o bloco se perder, o n nao avanca e o registo e reescrito a seguir
+			const int ch = s->base.first_channel + c;
+			unsigned seq = audio_capture_next_seq(ch);
+			Truth *tr = &s->truth[c][seq % TRUTH_RING];
+			atomic_store_explicit(&tr->seq, 0, memory_order_relaxed);
+			tr->speed_hz = truth_hz * (float)(1.0 + 0.05 * c);
+			tr->fault = truth_fault;
+			atomic_store_explicit(&tr->seq, seq + 1, memory_order_release);
+
+			audio_capture_push(ch, &s->base.fmt, s->block[c], ABUFSIZE_SAMPLES);
+		}
+	}
+
+	s->done = 1;
+	return NULL;
+}
+
+static int synth_start(AudioSource *src)
+{
+	SynthSource *s = (SynthSource *)src;
+	s->running = 1;
+	if (pthread_create(&s->th, NULL, synth_loop, s) != 0)
+	{
+		perror("synth");
+		s->running = 0;
+		return -1;
+	}
+	return 0;
+}
+
+static void synth_stop(AudioSource *src)
+{
+	SynthSource *s = (SynthSource *)src;
+	if (s->running)
+	{
+		s->running = 0;
+		pthread_join(s->th, NULL);
+	}
+}
+
+static int synth_finished(AudioSource *src)
+{
+	return ((SynthSource *)src)->done;
+}
+
+static void synth_close(AudioSource *src)
+{
+	synth_stop(src);
+	if (g_synth == (SynthSource *)src)
+		g_synth = NULL;
+	free(src);
+}
+
+AudioSource *audio_source_synth_open(const SynthParams *p, int first_channel)
+{
+	if (first_channel + p->channels > MAX_CHANNELS)
+	{
+		printf("synth: %d channels, at most %d in total\n", p->channels, MAX_CHANNELS);
+		return NULL;
+	}
+	SynthSource *s = calloc(1, sizeof(*s));
+	if (!s)
+		return NULL;
+	s->p = *p;
+	s->rng = 0x9E3779B97F4A7C15ull;
+	s->base.name = "synth";
+	s->base.rate = SAMP_FREQ;
+	s->base.channels = p->channels;
+	// Um bloco S16 por canal (nao intercalado)
+	ingest_format_init(&s->base.fmt, INGEST_S16, INGEST_HOST_BE, 1);
+	s->base.first_channel = first_channel;
+	s->base.start = synth_start;
+	s->base.stop = synth_stop;
+	s->base.finished = synth_finished;
+	s->base.close = synth_close;
+	g_synth = s;
+
+	printf("Using synthetic source: f0 %.1f->%.1f Hz in %.1f s, %d harmonics, "
+		   "fault %.1f Hz x%.2f from %.1f s, noise %.0f, %d ch, %.1f s, %s\n",
+		   p->f0_start, p->f0_end, p->ramp_s, p->harmonics,
+		   p->fault_hz, p->fault_amp, p->fault_start_s, p->noise, p->channels,
+		   p->duration_s, p->rate_mult > 0.0 ? "paced" : "fast");
+	if (p->rate_mult > 0.0)
+		printf("  rate: %.1fx real time (%.0f samples/s)\n", p->rate_mult, p->rate_mult * SAMP_FREQ);
+	return &s->base;
+}
+
+// NOTE - Verificação contra a verdade de referencia
+
+static const Truth *truth_get(int ch, unsigned seq)
+{
+	if (!g_synth)
+		return NULL;
+	const int c = ch - g_synth->base.first_channel;
+	if (c < 0 || c >= g_synth->p.channels)
+		return NULL; // canal de outra fonte
+	const Truth *tr = &g_synth->truth[c][seq % TRUTH_RING];
+	if (atomic_load_explicit(&tr->seq, memory_order_acquire) != seq + 1)
+		return NULL; // ja foi reescrito ou nunca existiu
+	return tr;
+}
+
+void truth_report_speed(int ch, unsigned seq, float hz)
+{
+	const Truth *tr = truth_get(ch, seq);
+	if (!tr)
+		return;
+
+	float err = fabsf(hz - tr->speed_hz);
+
+	atomic_fetch_add(&score.n_speed, 1);
+	if (err <= SPEED_TOL_HZ)
+		atomic_fetch_add(&score.speed_hits, 1);
+
+	score.speed_abs_err += err;
+	if (err > score.speed_max_err)
+		score.speed_max_err = err;
+}
+
+void truth_report_fault(int ch, unsigned seq, int fault)
+{
+	const Truth *tr = truth_get(ch, seq);
+	if (!tr)
+		return;
+
+	if (fault && tr->fault)
+		atomic_fetch_add(&score.tp, 1);
+	else if (fault)
+		atomic_fetch_add(&score.fp, 1);
+	else if (tr->fault)
+		atomic_fetch_add(&score.fn, 1);
+	else
+		atomic_fetch_add(&score.tn, 1);
+}
+
+void truth_print_summary(void)
+{
+	if (!g_synth)
+		return;
+
+	unsigned long n = atomic_load(&score.n_speed);
+	if (n > 0)
+		printf("[TRUTH] speed: %lu blocks, mean |err| %.2f Hz, max %.2f Hz, %.1f%% within %.1f Hz\n",
+			   n, score.speed_abs_err / n, score.speed_max_err,
+			   100.0 * atomic_load(&score.speed_hits) / n, SPEED_TOL_HZ);
+	printf("[TRUTH] bearing: TP=%lu FP=%lu FN=%lu TN=%lu\n",
+		   atomic_load(&score.tp), atomic_load(&score.fp),
+		   atomic_load(&score.fn), atomic_load(&score.tn));
+}
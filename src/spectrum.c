@@ -0,0 +1,103 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "spectrum.h"
+
+int spectrum_pool_init(SpectrumPool *p, int N)
+{
+	memset(p, 0, sizeof(*p));
+	p->plan = fftfPlanCreate(N, NULL);
+	if (!p->plan)
+	{
+		fprintf(stderr, "spectrum: invalid FFT size %d\n", N);
+		return -1;
+	}
+	p->N = N;
+
+	// Por slot: amplitudes e bins complexos (N/2+1, arredondado a 8) e bloco
+	// com janela (N), cada um alinhado a 32 bytes
+	const size_t namp = (size_t)(N / 2 + 8) & ~(size_t)7;
+	const size_t per_slot = 3 * namp + N;
+	p->mem = aligned_alloc(32, sizeof(float) * per_slot * SPECTRUM_POOL_SIZE);
+	p->window = aligned_alloc(32, sizeof(float) * ((N + 7) & ~7));
+	if (!p->mem || !p->window)
+	{
+		spectrum_pool_destroy(p);
+		return -1;
+	}
+
+	// Janela Hann precalculada
+	// A soma dos pesos normaliza as amplitudes (ganho coerente da janela)
+	double window_sum = 0.0;
+	for (int i = 0; i < N; i++)
+	{
+		p->window[i] = (float)(0.5 * (1.0 - cos(2.0 * M_PI * i / (N - 1))));
+		window_sum += p->window[i];
+	}
+	p->window_gain = (float)(1.0 / window_sum);
+
+	for (int i = 0; i < SPECTRUM_POOL_SIZE; i++)
+	{
+		p->slot[i].amp = p->mem + per_slot * i;
+		p->slot[i].re = p->slot[i].amp + namp;
+		p->slot[i].im = p->slot[i].re + namp;
+		p->slot[i].xw = p->slot[i].im + namp;
+		atomic_store(&p->slot[i].refs, 0);
+	}
+	return 0;
+}
+
+void spectrum_pool_destroy(SpectrumPool *p)
+{
+	fftfPlanDestroy(p->plan);
+	free(p->mem);
+	free(p->window);
+	p->plan = NULL;
+	p->mem = NULL;
+	p->window = NULL;
+}
+
+Spectrum *spectrum_compute(SpectrumPool *p, const float *x, float fs, int nrefs)
+{
+	if (!p->plan || nrefs <= 0)
+		return NULL;
+	const int N = p->N;
+
+	// Procurar slot livre
+	Spectrum *s = NULL;
+	for (int i = 0; i < SPECTRUM_POOL_SIZE; i++)
+	{
+		if (atomic_load_explicit(&p->slot[i].refs, memory_order_acquire) == 0)
+		{
+			s = &p->slot[i];
+			break;
+		}
+	}
+	if (!s)
+		return NULL;
+
+	// O bloco com janela fica no slot (interpolacao do pico no speed)
+	for (int i = 0; i < N; i++)
+		s->xw[i] = x[i] * p->window[i];
+	fftfRealExecute(p->plan, s->xw);
+
+	// Amplitudes de pico: 2|X|/sum(w), exceto DC e fs/2
+	s->N = N;
+	s->nbins = N / 2 + 1;
+	s->fs = fs;
+	fftfAmplitude(p->plan, s->amp, p->window_gain);
+	// Os bins complexos ficam no slot: o plan e reutilizado no bloco seguinte
+	memcpy(s->re, p->plan->re, sizeof(float) * s->nbins);
+	memcpy(s->im, p->plan->im, sizeof(float) * s->nbins);
+
+	// Publicar so depois de escrever os bins
+	atomic_store_explicit(&s->refs, nrefs, memory_order_release);
+	return s;
+}
+
+void spectrum_release(Spectrum *s)
+{
+	if (s)
+		atomic_fetch_sub_explicit(&s->refs, 1, memory_order_acq_rel);
+}
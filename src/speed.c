@@ -1,53 +1,96 @@
 #include <stdio.h>
-#include <time.h>
 #include "speed.h"
-#include "desc_queue.h"
-#include "dispatcher.h"
-#include "time_utils.h"
-#include "audio_io.h"
+#include "runtime.h"
+#include "channel.h"
 #include "config.h"
 #include "lpf.h"
-
-// NOTE - Thread de medição de Speed
-pthread_t speed_th;
-// Var de controlo do estado da thread
-volatile int speed_run = 1;
+#include "audio_source.h"
+#include "rt_stats.h"
+#include "speed_track.h"
+#include "rtlog.h"
+#include "telemetry.h"
+#include "time_utils.h"
 
 static RTDB *g_db = NULL;
-extern DescQueue *dispatcher_get_speed_queue(void);
-extern AudioBuf bufA, bufB; // para release
 
-void speed_set_rtdb(RTDB *db) { g_db = db; }
+// Seguidor com lock a volta da ultima estimativa da RTDB, um por canal
+// (as tarefas de um canal nunca correm em paralelo: sem locks)
+static SpeedTracker trk[MAX_CHANNELS];
+static int tracking = 0;
+static int nchannels = 0;
+
+static void speed_init(int nch)
+{
+    nchannels = nch;
+    tracking = SPEED_TRACK;
+    for (int c = 0; c < nch && tracking; c++)
+        tracking = speed_track_init(&trk[c], ANALYSIS_N, ANALYSIS_FS, SPEED_TRACK_SPAN_HZ) == 0;
+}
+
+void speed_print_stats(FILE *f)
+{
+    if (!tracking)
+        return;
+    unsigned long tracked = 0, full = 0, lost = 0;
+    for (int c = 0; c < nchannels; c++)
+    {
+        tracked += trk[c].tracked;
+        full += trk[c].full;
+        lost += trk[c].lost;
+    }
+    fprintf(f, "[SPEED] tracker: locked=%lu full searches=%lu lock losses=%lu\n",
+            tracked, full, lost);
+}
 
-void *speed_loop(void *arg)
+// NOTE - calculo do speed através do espectro do bloco
+// A FFT ja foi calculada uma vez pelo dispatcher do canal
+static void speed_process(const AudioDesc *d)
 {
-    (void)arg;
-    const long PERIOD_MS = 200;
-    struct timespec next_time;
-    clock_gettime(CLOCK_MONOTONIC, &next_time);
-    DescQueue *q = dispatcher_get_speed_queue();
-    while (speed_run)
+    uint64_t start = now_ns();
+    if (d->spec)
     {
-        add_ms(&next_time, PERIOD_MS);
-        AudioDesc d;
-        if (desc_queue_pop(q, &d))
-        {
-            // NOTE - calculo do speed através da FFT
-
-            // Converter o buffer em vetor de complexos
-            static double complex X[ABUFSIZE_SAMPLES];
-            for (int i = 0; i < d.len; ++i)
-                X[i] = d.ptr[i] + 0.0 * I;
-
-            // Calcular frequência dominante via FFT
-            float freq_est = compute_dominant_freq(X, d.len, SAMP_FREQ);
-
-            if (g_db)
-                rtdb_set_speed(g_db, freq_est);
-            printf("[SPEED] cycle: len=%d\n", d.len);
-            audio_release_buffer(d.ptr);
-        }
-        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next_time, NULL);
+        float freq_est = tracking
+            ? speed_track_update(&trk[d->ch], d->spec, g_db ? rtdb_get_speed(g_db, d->ch) : 0.0f)
+            : compute_dominant_freq(d->spec);
+
+        if (g_db)
+            rtdb_set_speed(g_db, d->ch, freq_est, d->t_capture, d->seq);
+        truth_report_speed(d->ch, d->seq, freq_est);
+
+        // NOTE - Registo de telemetria do bloco (so uma copia para o anel do canal)
+        uint64_t end = now_ns();
+        TelemetryRecord r = {
+            .t_capture = d->t_capture,
+            .block = d->seq,
+            .ch = (uint16_t)d->ch,
+            .fault = (uint8_t)d->fault,
+            .speed_hz = freq_est,
+            .lf_peak = d->lf_peak,
+            .motor_peak = d->motor_peak,
+            .wait_ns = telem_ns32(d->t_capture, d->t_dispatch),
+            .dispatch_ns = telem_ns32(d->t_dispatch, d->t_ready),
+            .queue_ns = telem_ns32(d->t_ready, start),
+            .speed_ns = telem_ns32(start, end),
+        };
+        telemetry_record(&r);
     }
-    return NULL;
-}
\ No newline at end of file
+    RTLOG(RTLOG_DEBUG, "[SPEED] cycle: ch=%d len=%d\n", d->ch, d->len);
+}
+
+// Periodo de 200 ms (deadline relativa), prioridade mais alta
+static const Analysis speed_analysis = {
+    .name = "speed",
+    .stats = RT_SPEED,
+    .prio = 0,
+    .period_ms = 200,
+    .latest_only = 0,
+    .uses_spectrum = 1,
+    .init = speed_init,
+    .process = speed_process,
+};
+
+int speed_register(RTDB *db)
+{
+    g_db = db;
+    return runtime_register(&speed_analysis);
+}
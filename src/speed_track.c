@@ -0,0 +1,66 @@
+#include <math.h>
+#include "speed_track.h"
+#include "peak.h"
+#include "lpf.h"
+#include "config.h"
+
+int speed_track_init(SpeedTracker *t, int N, float fs, float span_hz)
+{
+	*t = (SpeedTracker){0};
+	if (span_hz <= 0.0f || span_hz >= fs / 2)
+		return -1;
+	t->N = N;
+	t->fs = fs;
+	t->span_hz = span_hz;
+	return 0;
+}
+
+// Procura em todo o espectro; a amplitude do bin do novo pico passa a ser
+// a referencia do lock
+static float full_search(SpeedTracker *t, const Spectrum *s)
+{
+	t->full++;
+	t->since_full = 0;
+	float hz = compute_dominant_freq(s);
+	t->locked = hz > 0.0f;
+	if (t->locked)
+		t->ref_amp = s->amp[(int)lrintf(hz * s->N / s->fs)];
+	return hz;
+}
+
+float speed_track_update(SpeedTracker *t, const Spectrum *s, float last_hz)
+{
+	if (s->N != t->N || s->fs != t->fs)
+		return compute_dominant_freq(s);
+	if (!t->locked || last_hz <= 0.0f || ++t->since_full >= SPEED_TRACK_REACQUIRE)
+		return full_search(t, s);
+
+	// Bins da banda [last - span/2, last + span/2], pelo menos dois de cada
+	// lado do bin da ultima estimativa (o pico entre dois bins pode cair no
+	// vizinho sem sair da banda), sem o DC nem o de fs/2
+	const float bins_per_hz = (float)s->N / s->fs;
+	const int kc = (int)lrintf(last_hz * bins_per_hz);
+	int half = (int)ceilf(t->span_hz / 2 * bins_per_hz);
+	if (half < 2)
+		half = 2;
+	int k0 = kc - half, k1 = kc + half;
+	if (k0 < 1)
+		k0 = 1;
+	if (k1 > s->nbins - 2)
+		k1 = s->nbins - 2;
+	const int k = k1 > k0 ? fftfBestKernels()->peak(s->amp, k0, k1 + 1) : -1;
+
+	// Pico na borda (fora da banda) ou amplitude a cair: perdeu o lock
+	if (k <= k0 || k >= k1 || s->amp[k] < SPEED_TRACK_LOCK_RATIO * t->ref_amp)
+	{
+		t->lost++;
+		return full_search(t, s);
+	}
+	t->ref_amp = 0.8f * t->ref_amp + 0.2f * s->amp[k];
+	t->tracked++;
+
+	float kf = peak_interp(s->amp, s->re, s->im, s->N, k, SPEED_PEAK_METHOD);
+	if (SPEED_ZOOM > 0)
+		kf = peak_zoom(s->xw, s->N, kf, SPEED_ZOOM);
+	return kf / bins_per_hz;
+}
@@ -0,0 +1,323 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "telemetry.h"
+#include "config.h"
+#include "time_utils.h"
+
+// NOTE - Colunas: offset e tipo de cada campo de TelemetryRecord
+typedef struct
+{
+	const char *name;
+	TelemType type;
+	size_t size;
+	size_t off;
+} ColumnDef;
+
+#define COL(field, t) {#field, t, sizeof(((TelemetryRecord *)0)->field), offsetof(TelemetryRecord, field)}
+static const ColumnDef cols[] = {
+	COL(t_capture, TELEM_U64),
+	COL(block, TELEM_U32),
+	COL(ch, TELEM_U16),
+	COL(fault, TELEM_U8),
+	COL(speed_hz, TELEM_F32),
+	COL(lf_peak, TELEM_F32),
+	COL(motor_peak, TELEM_F32),
+	COL(wait_ns, TELEM_U32),
+	COL(dispatch_ns, TELEM_U32),
+	COL(queue_ns, TELEM_U32),
+	COL(speed_ns, TELEM_U32),
+};
+#define NCOLS ((int)(sizeof(cols) / sizeof(cols[0])))
+_Static_assert(NCOLS <= TELEM_MAX_COLS, "too many telemetry columns");
+_Static_assert(sizeof(TelemFileHeader) <= TELEM_ALIGN, "header larger than a block");
+_Static_assert(sizeof(TelemIndex) <= TELEM_ALIGN, "index larger than a block");
+
+#define ALIGN_UP(x, a) (((x) + (a) - 1) / (a) * (a))
+
+// NOTE - Anel SPSC de um canal (produtor: tarefa do speed; consumidor: escrita)
+typedef struct
+{
+	_Alignas(CACHE_LINE) atomic_uint head;
+	atomic_ulong dropped;
+	_Alignas(CACHE_LINE) atomic_uint tail;
+	TelemetryRecord rec[TELEM_RING];
+} TelemRing;
+
+static TelemRing *rings = NULL;
+static int nrings = 0;
+
+// Estado da thread de escrita
+static int fd = -1;
+static int direct = 0;			  // O_DIRECT ativo
+static uint64_t file_off = 0;	  // proximo offset a escrever
+static uint64_t chunks = 0, records = 0;
+static unsigned long write_errors = 0;
+static TelemetryRecord *rows = NULL; // registos do chunk em construcao
+static int nrows = 0;
+static uint64_t first_row_t = 0;	 // instante em que entrou o primeiro
+static unsigned char *out = NULL;	 // chunk colunar (alinhado a TELEM_ALIGN)
+static size_t out_size = 0;
+static TelemIndex *index_blk = NULL; // indice em construcao
+static uint64_t prev_index = 0;
+
+static pthread_t writer_th;
+static volatile int writer_run = 0;
+
+void telemetry_record(const TelemetryRecord *r)
+{
+	if (!rings || r->ch >= nrings)
+		return;
+	TelemRing *q = &rings[r->ch];
+	unsigned head = atomic_load_explicit(&q->head, memory_order_relaxed);
+	unsigned tail = atomic_load_explicit(&q->tail, memory_order_acquire);
+	if (head - tail == TELEM_RING)
+	{
+		atomic_fetch_add_explicit(&q->dropped, 1, memory_order_relaxed);
+		return;
+	}
+	q->rec[head & (TELEM_RING - 1)] = *r;
+	atomic_store_explicit(&q->head, head + 1, memory_order_release);
+}
+
+// Escrita de um bloco alinhado no fim do ficheiro
+static int write_blocks(const void *buf, size_t len)
+{
+	const char *p = buf;
+	size_t done = 0;
+	while (done < len)
+	{
+		ssize_t w = pwrite(fd, p + done, len - done, (off_t)(file_off + done));
+		if (w < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			write_errors++;
+			return -1;
+		}
+		done += (size_t)w;
+	}
+	file_off += len;
+	return 0;
+}
+
+static void write_index(void)
+{
+	index_blk->magic = TELEM_MAGIC_INDEX;
+	index_blk->prev = prev_index;
+	index_blk->total = records;
+	memset(out, 0, TELEM_ALIGN);
+	memcpy(out, index_blk, sizeof(*index_blk));
+	uint64_t off = file_off;
+	if (write_blocks(out, TELEM_ALIGN) == 0)
+		prev_index = off;
+	memset(index_blk, 0, sizeof(*index_blk));
+}
+
+// NOTE - Transposicao das linhas para um chunk colunar e escrita
+static void write_chunk(void)
+{
+	if (nrows == 0)
+		return;
+
+	TelemChunkHeader h = {.magic = TELEM_MAGIC_CHUNK, .nrec = (uint32_t)nrows, .seq = chunks};
+	h.t_first = h.t_last = rows[0].t_capture;
+	size_t off = ALIGN_UP(sizeof(h), 8);
+	for (int c = 0; c < NCOLS; c++)
+	{
+		h.col_off[c] = (uint32_t)off;
+		unsigned char *dst = out + off;
+		const unsigned char *src = (const unsigned char *)rows + cols[c].off;
+		for (int i = 0; i < nrows; i++)
+			memcpy(dst + i * cols[c].size, src + i * sizeof(TelemetryRecord), cols[c].size);
+		off = ALIGN_UP(off + nrows * cols[c].size, 8);
+	}
+	for (int i = 0; i < nrows; i++)
+	{
+		h.ch_mask |= 1u << rows[i].ch;
+		if (rows[i].t_capture < h.t_first)
+			h.t_first = rows[i].t_capture;
+		if (rows[i].t_capture > h.t_last)
+			h.t_last = rows[i].t_capture;
+	}
+	h.bytes = (uint32_t)ALIGN_UP(off, TELEM_ALIGN);
+	memset(out + off, 0, h.bytes - off);
+	memcpy(out, &h, sizeof(h));
+
+	uint64_t chunk_off = file_off;
+	if (write_blocks(out, h.bytes) == 0)
+	{
+		TelemIndexEntry *e = &index_blk->e[index_blk->n++];
+		e->off = chunk_off;
+		e->nrec = h.nrec;
+		e->ch_mask = h.ch_mask;
+		e->t_first = h.t_first;
+		e->t_last = h.t_last;
+		chunks++;
+		records += nrows;
+		if (index_blk->n == TELEM_INDEX_CHUNKS)
+			write_index();
+	}
+	nrows = 0;
+}
+
+// Passa os registos dos aneis para as linhas do chunk
+static void collect(void)
+{
+	for (int c = 0; c < nrings; c++)
+	{
+		TelemRing *q = &rings[c];
+		unsigned tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+		unsigned head = atomic_load_explicit(&q->head, memory_order_acquire);
+		while (tail != head)
+		{
+			if (nrows == 0)
+				first_row_t = now_ns();
+			rows[nrows++] = q->rec[tail & (TELEM_RING - 1)];
+			tail++;
+			if (nrows == TELEM_CHUNK_RECORDS)
+			{
+				atomic_store_explicit(&q->tail, tail, memory_order_release);
+				write_chunk();
+			}
+		}
+		atomic_store_explicit(&q->tail, tail, memory_order_release);
+	}
+}
+
+// NOTE - Thread de escrita
+// Chunks completos sao escritos logo; um chunk incompleto espera no maximo
+// TELEM_FLUSH_MS (o que se perde numa falha)
+static void *writer_loop(void *arg)
+{
+	(void)arg;
+	struct timespec next;
+	clock_gettime(CLOCK_MONOTONIC, &next);
+	while (writer_run)
+	{
+		collect();
+		if (nrows > 0 && now_ns() - first_row_t >= TELEM_FLUSH_MS * 1000000ull)
+			write_chunk();
+		add_ms(&next, TELEM_POLL_MS);
+		clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+	}
+	return NULL;
+}
+
+int telemetry_start(const char *path, int nch)
+{
+	// O_DIRECT nao existe em todos os sistemas de ficheiros (ex.: tmpfs)
+	direct = 1;
+	fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_DIRECT, 0644);
+	if (fd < 0 && errno == EINVAL)
+	{
+		direct = 0;
+		fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	}
+	if (fd < 0)
+	{
+		perror(path);
+		return -1;
+	}
+
+	size_t col_bytes = 0;
+	for (int c = 0; c < NCOLS; c++)
+		col_bytes += ALIGN_UP(TELEM_CHUNK_RECORDS * cols[c].size, 8);
+	out_size = ALIGN_UP(ALIGN_UP(sizeof(TelemChunkHeader), 8) + col_bytes, TELEM_ALIGN);
+	out = aligned_alloc(TELEM_ALIGN, out_size);
+	rows = malloc(sizeof(TelemetryRecord) * TELEM_CHUNK_RECORDS);
+	index_blk = calloc(1, sizeof(*index_blk));
+	rings = aligned_alloc(CACHE_LINE, ALIGN_UP(sizeof(TelemRing) * nch, CACHE_LINE));
+	if (!out || !rows || !index_blk || !rings)
+	{
+		printf("telemetry: out of memory\n");
+		telemetry_stop();
+		return -1;
+	}
+	for (int c = 0; c < nch; c++)
+	{
+		atomic_init(&rings[c].head, 0);
+		atomic_init(&rings[c].tail, 0);
+		atomic_init(&rings[c].dropped, 0);
+	}
+
+	// Cabecalho: descricao das colunas e relogios de referencia
+	TelemFileHeader h = {.magic = TELEM_MAGIC_FILE, .version = TELEM_VERSION,
+						 .ncols = NCOLS, .nch = (uint32_t)nch};
+	struct timespec rt;
+	h.t_start_mono = now_ns();
+	clock_gettime(CLOCK_REALTIME, &rt);
+	h.t_start_real = (int64_t)ts_to_ns(&rt);
+	for (int c = 0; c < NCOLS; c++)
+	{
+		strncpy(h.col[c].name, cols[c].name, sizeof(h.col[c].name) - 1);
+		h.col[c].type = cols[c].type;
+		h.col[c].size = (uint32_t)cols[c].size;
+	}
+	memset(out, 0, TELEM_ALIGN);
+	memcpy(out, &h, sizeof(h));
+	file_off = 0;
+	chunks = records = 0;
+	prev_index = 0;
+	nrows = 0;
+	if (write_blocks(out, TELEM_ALIGN) != 0)
+	{
+		perror(path);
+		telemetry_stop();
+		return -1;
+	}
+	nrings = nch;
+
+	writer_run = 1;
+	if (pthread_create(&writer_th, NULL, writer_loop, NULL) != 0)
+	{
+		perror("telemetry");
+		writer_run = 0;
+		telemetry_stop();
+		return -1;
+	}
+	printf("[TELEMETRY] %s (%s, %d columns, %d records per chunk)\n", path,
+		   direct ? "O_DIRECT" : "buffered", NCOLS, TELEM_CHUNK_RECORDS);
+	return 0;
+}
+
+// Chamado depois de parar os produtores
+void telemetry_stop(void)
+{
+	if (writer_run)
+	{
+		writer_run = 0;
+		pthread_join(writer_th, NULL);
+	}
+	unsigned long dropped = 0;
+	if (fd >= 0 && rings && nrings > 0)
+	{
+		collect();
+		write_chunk();
+		write_index();
+		fdatasync(fd);
+		for (int c = 0; c < nrings; c++)
+			dropped += atomic_load(&rings[c].dropped);
+		printf("[TELEMETRY] records=%lu chunks=%lu bytes=%lu dropped=%lu write errors=%lu\n",
+			   (unsigned long)records, (unsigned long)chunks, (unsigned long)file_off,
+			   dropped, write_errors);
+	}
+	if (fd >= 0)
+		close(fd);
+	fd = -1;
+	nrings = 0;
+	free(rings);
+	free(rows);
+	free(out);
+	free(index_blk);
+	rings = NULL;
+	rows = NULL;
+	out = NULL;
+	index_blk = NULL;
+}
@@ -0,0 +1,86 @@
+#include <stdlib.h>
+#include "wsdeque.h"
+
+int wsdeque_init(WsDeque *q, int capacity)
+{
+	long cap = 1;
+	while (cap < capacity)
+		cap <<= 1;
+	q->buf = calloc(cap, sizeof(atomic_long));
+	if (!q->buf)
+		return -1;
+	q->mask = cap - 1;
+	atomic_init(&q->top, 0);
+	atomic_init(&q->bottom, 0);
+	return 0;
+}
+
+void wsdeque_destroy(WsDeque *q)
+{
+	free(q->buf);
+	q->buf = NULL;
+}
+
+int wsdeque_push(WsDeque *q, long v)
+{
+	long b = atomic_load_explicit(&q->bottom, memory_order_relaxed);
+	long t = atomic_load_explicit(&q->top, memory_order_acquire);
+	if (b - t > q->mask)
+		return 0;
+	atomic_store_explicit(&q->buf[b & q->mask], v, memory_order_relaxed);
+	// o elemento fica visivel antes do novo fundo
+	atomic_thread_fence(memory_order_release);
+	atomic_store_explicit(&q->bottom, b + 1, memory_order_relaxed);
+	return 1;
+}
+
+int wsdeque_pop(WsDeque *q, long *v)
+{
+	long b = atomic_load_explicit(&q->bottom, memory_order_relaxed) - 1;
+	atomic_store_explicit(&q->bottom, b, memory_order_relaxed);
+	// o fundo reservado tem de ser visivel aos ladroes antes de ler o topo
+	atomic_thread_fence(memory_order_seq_cst);
+	long t = atomic_load_explicit(&q->top, memory_order_relaxed);
+
+	if (t > b)
+	{
+		// vazio
+		atomic_store_explicit(&q->bottom, b + 1, memory_order_relaxed);
+		return 0;
+	}
+	*v = atomic_load_explicit(&q->buf[b & q->mask], memory_order_relaxed);
+	if (t < b)
+		return 1;
+
+	// Ultimo elemento: disputado com os ladroes pelo topo
+	int won = atomic_compare_exchange_strong_explicit(&q->top, &t, t + 1,
+													  memory_order_seq_cst,
+													  memory_order_relaxed);
+	atomic_store_explicit(&q->bottom, b + 1, memory_order_relaxed);
+	return won;
+}
+
+int wsdeque_steal(WsDeque *q, long *v)
+{
+	long t = atomic_load_explicit(&q->top, memory_order_acquire);
+	atomic_thread_fence(memory_order_seq_cst);
+	long b = atomic_load_explicit(&q->bottom, memory_order_acquire);
+	if (t >= b)
+		return 0;
+
+	// Ler antes do CAS: se outro ganhar, o valor e ignorado
+	long x = atomic_load_explicit(&q->buf[t & q->mask], memory_order_relaxed);
+	if (!atomic_compare_exchange_strong_explicit(&q->top, &t, t + 1,
+												 memory_order_seq_cst,
+												 memory_order_relaxed))
+		return 0;
+	*v = x;
+	return 1;
+}
+
+long wsdeque_size(WsDeque *q)
+{
+	long b = atomic_load_explicit(&q->bottom, memory_order_relaxed);
+	long t = atomic_load_explicit(&q->top, memory_order_relaxed);
+	return b > t ? b - t : 0;
+}
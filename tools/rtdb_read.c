@@ -0,0 +1,163 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <signal.h>
+#include "rtdb_shm.h"
+#include "time_utils.h"
+
+// NOTE - Leitor da RTDB exportada pelo audio_app (rtdb_shm.h)
+// Mostra o ultimo valor de cada canal, o historico ou mede a taxa de leitura
+
+static volatile sig_atomic_t run = 1;
+
+static void on_sigint(int sig)
+{
+    (void)sig;
+    run = 0;
+}
+
+static void usage(const char *prog)
+{
+    printf("Usage: %s [options]\n"
+           "  -m  shared-memory name (default: %s)\n"
+           "  -c  only this channel (default: all)\n"
+           "  -H  print the last n values of each field (max %d)\n"
+           "  -i  repeat every ms until Ctrl-C (default: print once)\n"
+           "  -b  measure reads per second for this many seconds\n",
+           prog, RTDB_SHM_NAME, RTDB_HISTORY);
+}
+
+static void print_channel(const RTDB *db, int c, int hist, uint64_t now)
+{
+    RtdbSample sp, bf;
+    int have_sp = rtdb_read(db, RTDB_SPEED, c, &sp);
+    int have_bf = rtdb_read(db, RTDB_BEARING, c, &bf);
+    printf("ch %2d ", c);
+    if (have_sp > 0)
+        printf("speed %8.2f Hz block %6u age %7.1f ms", sp.speed_hz, sp.block, (now - sp.t_capture) / 1e6);
+    else
+        printf("speed     %s ", have_sp < 0 ? "busy" : "   -");
+    if (have_bf > 0)
+        printf(" | bearing %s block %6u age %7.1f ms\n", bf.fault ? "FAULT" : "OK   ", bf.block, (now - bf.t_capture) / 1e6);
+    else
+        printf(" | bearing %s\n", have_bf < 0 ? "busy" : "-");
+
+    if (hist <= 0)
+        return;
+    RtdbSample h[RTDB_HISTORY];
+    int n = rtdb_history(db, RTDB_SPEED, c, h, hist);
+    printf("   speed  :");
+    if (n < 0)
+        printf(" busy");
+    for (int i = 0; i < n; i++)
+        printf(" %.1f", h[i].speed_hz);
+    n = rtdb_history(db, RTDB_BEARING, c, h, hist);
+    printf("\n   bearing:");
+    if (n < 0)
+        printf(" busy");
+    for (int i = 0; i < n; i++)
+        printf(" %d", h[i].fault);
+    printf("\n");
+}
+
+// Leituras seguidas do ultimo valor de todos os canais
+static void bench(const RTDB *db, int first, int last, int seconds)
+{
+    uint64_t t0 = now_ns(), end = t0 + seconds * 1000000000ull, t;
+    unsigned long reads = 0, busy = 0;
+    RtdbSample s;
+    do
+    {
+        for (int i = 0; i < 1000; i++)
+            for (int c = first; c <= last; c++)
+            {
+                busy += rtdb_read(db, RTDB_SPEED, c, &s) < 0;
+                busy += rtdb_read(db, RTDB_BEARING, c, &s) < 0;
+                reads += 2;
+            }
+        t = now_ns();
+    } while (t < end && run);
+    printf("%lu reads in %.2f s: %.1f Mreads/s (%.0f ns/read), %lu busy\n", reads, (t - t0) / 1e9,
+           reads / ((t - t0) / 1e3), (double)(t - t0) / reads, busy);
+}
+
+int main(int argc, char **argv)
+{
+    const char *name = RTDB_SHM_NAME;
+    int only = -1, hist = 0, seconds = 0;
+    long interval = 0;
+    int opt;
+    while ((opt = getopt(argc, argv, "m:c:H:i:b:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'm':
+            name = optarg;
+            break;
+        case 'c':
+            only = atoi(optarg);
+            break;
+        case 'H':
+            hist = atoi(optarg);
+            break;
+        case 'i':
+            interval = atol(optarg);
+            break;
+        case 'b':
+            seconds = atoi(optarg);
+            break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    const RtdbShm *shm = rtdb_shm_open(name);
+    if (!shm)
+    {
+        fprintf(stderr, "%s: %s\n", name,
+                errno == EPROTO ? "incompatible layout" : strerror(errno));
+        return 1;
+    }
+    const RTDB *db = &shm->db;
+    int first = 0, last = db->nch - 1;
+    if (only >= 0)
+    {
+        if (only >= db->nch)
+        {
+            fprintf(stderr, "channel %d: the writer has %d channel(s)\n", only, db->nch);
+            rtdb_shm_close(shm);
+            return 1;
+        }
+        first = last = only;
+    }
+    signal(SIGINT, on_sigint);
+
+    if (seconds > 0)
+        bench(db, first, last, seconds);
+    else
+    {
+        struct timespec next;
+        clock_gettime(CLOCK_MONOTONIC, &next);
+        do
+        {
+            uint64_t now = now_ns();
+            unsigned state = atomic_load_explicit(&shm->hdr.state, memory_order_acquire);
+            printf("[RTDB] pid %d %s, %d channel(s), up %.1f s\n", shm->hdr.pid,
+                   state == RTDB_SHM_RUNNING ? "running" : "stopped", db->nch,
+                   (now - shm->hdr.t_start) / 1e9);
+            for (int c = first; c <= last; c++)
+                print_channel(db, c, hist, now);
+            fflush(stdout);
+            if (interval <= 0 || state != RTDB_SHM_RUNNING)
+                break;
+            add_ms(&next, interval);
+            clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+        } while (run);
+    }
+
+    rtdb_shm_close(shm);
+    return 0;
+}
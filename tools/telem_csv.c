@@ -0,0 +1,224 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "telemetry.h"
+
+// NOTE - Leitor dos ficheiros de telemetria (telemetry.h)
+// Converte os chunks colunares para CSV (uma linha por registo) ou lista
+// os indices. Os chunks sao percorridos desde o inicio, por isso tambem le
+// ficheiros sem o indice final (gravacao interrompida).
+
+static void usage(const char *prog)
+{
+    printf("Usage: %s [options] file\n"
+           "  -c  only this channel\n"
+           "  -i  list the chunks from the index footers instead of the records\n",
+           prog);
+}
+
+static int read_at(int fd, void *buf, size_t len, uint64_t off)
+{
+    return pread(fd, buf, len, (off_t)off) == (ssize_t)len ? 0 : -1;
+}
+
+static void print_value(const TelemColumn *c, const unsigned char *p)
+{
+    switch (c->type)
+    {
+    case TELEM_U8:
+        printf("%u", *p);
+        break;
+    case TELEM_U16:
+    {
+        uint16_t v;
+        memcpy(&v, p, sizeof(v));
+        printf("%u", v);
+        break;
+    }
+    case TELEM_U32:
+    {
+        uint32_t v;
+        memcpy(&v, p, sizeof(v));
+        printf("%u", v);
+        break;
+    }
+    case TELEM_U64:
+    {
+        uint64_t v;
+        memcpy(&v, p, sizeof(v));
+        printf("%llu", (unsigned long long)v);
+        break;
+    }
+    case TELEM_F32:
+    {
+        float v;
+        memcpy(&v, p, sizeof(v));
+        printf("%.6g", v);
+        break;
+    }
+    default:
+        printf("?");
+    }
+}
+
+// Indices do fim para o inicio (lista ligada por prev)
+static int list_index(int fd, uint64_t size)
+{
+    if (size < 2 * TELEM_ALIGN)
+        return -1;
+    TelemIndex ix;
+    uint64_t off = size - TELEM_ALIGN;
+    if (read_at(fd, &ix, sizeof(ix), off) != 0 || ix.magic != TELEM_MAGIC_INDEX)
+    {
+        fprintf(stderr, "no index footer at the end (interrupted recording?)\n");
+        return -1;
+    }
+    printf("%llu records\n", (unsigned long long)ix.total);
+    printf("index_off,chunk_off,nrec,ch_mask,t_first,t_last\n");
+    for (;;)
+    {
+        for (uint32_t i = 0; i < ix.n && i < TELEM_INDEX_CHUNKS; i++)
+            printf("%llu,%llu,%u,0x%x,%llu,%llu\n", (unsigned long long)off,
+                   (unsigned long long)ix.e[i].off, ix.e[i].nrec, ix.e[i].ch_mask,
+                   (unsigned long long)ix.e[i].t_first, (unsigned long long)ix.e[i].t_last);
+        if (ix.prev == 0)
+            break;
+        off = ix.prev;
+        if (read_at(fd, &ix, sizeof(ix), off) != 0 || ix.magic != TELEM_MAGIC_INDEX)
+        {
+            fprintf(stderr, "broken index chain at %llu\n", (unsigned long long)off);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    int only = -1, index = 0;
+    int opt;
+    while ((opt = getopt(argc, argv, "c:i")) != -1)
+    {
+        switch (opt)
+        {
+        case 'c':
+            only = atoi(optarg);
+            break;
+        case 'i':
+            index = 1;
+            break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (optind >= argc)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    const char *path = argv[optind];
+    int fd = open(path, O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0)
+    {
+        perror(path);
+        return 1;
+    }
+    TelemFileHeader h;
+    if (read_at(fd, &h, sizeof(h), 0) != 0 || h.magic != TELEM_MAGIC_FILE ||
+        h.version != TELEM_VERSION || h.ncols == 0 || h.ncols > TELEM_MAX_COLS)
+    {
+        fprintf(stderr, "%s: not a telemetry file (version %d)\n", path, TELEM_VERSION);
+        close(fd);
+        return 1;
+    }
+    if (index)
+    {
+        int ret = list_index(fd, (uint64_t)st.st_size);
+        close(fd);
+        return ret ? 1 : 0;
+    }
+
+    // Coluna do canal (para -c) e do instante (para o tempo relativo)
+    int ch_col = -1, t_col = -1;
+    printf("time_s");
+    for (uint32_t c = 0; c < h.ncols; c++)
+    {
+        h.col[c].name[sizeof(h.col[c].name) - 1] = '\0';
+        printf(",%s", h.col[c].name);
+        if (strcmp(h.col[c].name, "ch") == 0 && h.col[c].type == TELEM_U16)
+            ch_col = (int)c;
+        if (strcmp(h.col[c].name, "t_capture") == 0 && h.col[c].type == TELEM_U64)
+            t_col = (int)c;
+    }
+    printf("\n");
+
+    unsigned char *chunk = NULL;
+    size_t chunk_cap = 0;
+    uint64_t off = TELEM_ALIGN;
+    unsigned long nrec = 0;
+    while (off + TELEM_ALIGN <= (uint64_t)st.st_size)
+    {
+        TelemChunkHeader ch;
+        if (read_at(fd, &ch, sizeof(ch), off) != 0)
+            break;
+        if (ch.magic == TELEM_MAGIC_INDEX)
+        {
+            off += TELEM_ALIGN;
+            continue;
+        }
+        if (ch.magic != TELEM_MAGIC_CHUNK || ch.bytes < TELEM_ALIGN || off + ch.bytes > (uint64_t)st.st_size)
+            break; // fim de uma gravacao interrompida
+        if (only >= 0 && only < 32 && !(ch.ch_mask & (1u << only)))
+        {
+            off += ch.bytes;
+            continue;
+        }
+        if (ch.bytes > chunk_cap)
+        {
+            free(chunk);
+            chunk_cap = ch.bytes;
+            chunk = malloc(chunk_cap);
+            if (!chunk)
+                break;
+        }
+        if (read_at(fd, chunk, ch.bytes, off) != 0)
+            break;
+
+        for (uint32_t i = 0; i < ch.nrec; i++)
+        {
+            if (only >= 0 && ch_col >= 0)
+            {
+                uint16_t v;
+                memcpy(&v, chunk + ch.col_off[ch_col] + i * sizeof(v), sizeof(v));
+                if (v != only)
+                    continue;
+            }
+            double t = 0.0;
+            if (t_col >= 0)
+            {
+                uint64_t v;
+                memcpy(&v, chunk + ch.col_off[t_col] + i * sizeof(v), sizeof(v));
+                t = ((double)v - (double)h.t_start_mono) / 1e9;
+            }
+            printf("%.6f", t);
+            for (uint32_t c = 0; c < h.ncols; c++)
+            {
+                putchar(',');
+                print_value(&h.col[c], chunk + ch.col_off[c] + (size_t)i * h.col[c].size);
+            }
+            putchar('\n');
+            nrec++;
+        }
+        off += ch.bytes;
+    }
+    free(chunk);
+    close(fd);
+    fprintf(stderr, "%lu records\n", nrec);
+    return 0;
+}